@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/ship_space.h"
+#include "../src/timer.h"
+
+/* compares the paged chunk_index against the hash map it replaced, on a
+ * large synthetic hull. the interesting numbers are lookup-bound: random
+ * chunk fetches, and the 6-neighbour walk that topology rebuilds and
+ * raycasts do for every block.
+ */
+
+/* ship_space wants this from the game; nothing is attached here. */
+void
+remove_ents_from_surface(glm::ivec3, int)
+{
+}
+
+static glm::ivec3 const hull_chunks(24, 96, 8);
+
+static glm::ivec3 const neighbours[] = {
+    glm::ivec3(1, 0, 0), glm::ivec3(-1, 0, 0),
+    glm::ivec3(0, 1, 0), glm::ivec3(0, -1, 0),
+    glm::ivec3(0, 0, 1), glm::ivec3(0, 0, -1),
+};
+
+static ship_space *
+build_hull()
+{
+    auto *ship = new ship_space;
+    glm::ivec3 extent = hull_chunks * CHUNK_SIZE;
+
+    for (int k = 0; k < extent.z; k++) {
+        for (int j = 0; j < extent.y; j++) {
+            for (int i = 0; i < extent.x; i++) {
+                block bl = ship->ensure_block(glm::ivec3(i, j, k));
+                /* framing on every fourth plane, like bulkheads and decks */
+                *bl.type = (i % 4 == 0 || j % 4 == 0 || k % 4 == 0) ? block_frame : block_empty;
+            }
+        }
+    }
+
+    return ship;
+}
+
+static chunk *
+hash_get_block_chunk(std::unordered_map<glm::ivec3, chunk *, ivec3_hash> const &m, glm::ivec3 b)
+{
+    glm::ivec3 ch(b.x < 0 ? (b.x - CHUNK_SIZE + 1) / CHUNK_SIZE : b.x / CHUNK_SIZE,
+                  b.y < 0 ? (b.y - CHUNK_SIZE + 1) / CHUNK_SIZE : b.y / CHUNK_SIZE,
+                  b.z < 0 ? (b.z - CHUNK_SIZE + 1) / CHUNK_SIZE : b.z / CHUNK_SIZE);
+    auto it = m.find(ch);
+    return it == m.end() ? nullptr : it->second;
+}
+
+int
+main(void)
+{
+    Timer timer;
+
+    ship_space *ship = build_hull();
+    printf("hull: %zu chunks\n", ship->chunks.size());
+
+    std::unordered_map<glm::ivec3, chunk *, ivec3_hash> hashed;
+    for (auto ch : ship->chunks) {
+        hashed[ch.first] = ch.second;
+    }
+
+    /* 1/ random chunk lookups, including some misses outside the hull */
+    std::vector<glm::ivec3> probes;
+    srand(1);
+    for (int n = 0; n < 4000000; n++) {
+        probes.emplace_back(rand() % (hull_chunks.x + 4) - 2,
+                            rand() % (hull_chunks.y + 4) - 2,
+                            rand() % (hull_chunks.z + 4) - 2);
+    }
+
+    size_t found = 0;
+    timer.touch();
+    for (auto p : probes) {
+        found += hashed.find(p) != hashed.end();
+    }
+    double hash_random = timer.touch().delta;
+
+    size_t found2 = 0;
+    for (auto p : probes) {
+        found2 += ship->get_chunk(p) != nullptr;
+    }
+    double index_random = timer.touch().delta;
+
+    printf("random chunk lookup: hash %.3fs, paged %.3fs (%zu/%zu hits)\n",
+           hash_random, index_random, found, found2);
+
+    /* 2/ neighbour walk over every block, as the topology rebuild does */
+    glm::ivec3 extent = hull_chunks * CHUNK_SIZE;
+    size_t sum = 0;
+    timer.touch();
+    for (int k = 0; k < extent.z; k++) {
+        for (int j = 0; j < extent.y; j++) {
+            for (int i = 0; i < extent.x; i++) {
+                for (auto n : neighbours) {
+                    sum += hash_get_block_chunk(hashed, glm::ivec3(i, j, k) + n) != nullptr;
+                }
+            }
+        }
+    }
+    double hash_walk = timer.touch().delta;
+
+    size_t sum2 = 0;
+    for (int k = 0; k < extent.z; k++) {
+        for (int j = 0; j < extent.y; j++) {
+            for (int i = 0; i < extent.x; i++) {
+                for (auto n : neighbours) {
+                    sum2 += (bool)ship->peek_block(glm::ivec3(i, j, k) + n);
+                }
+            }
+        }
+    }
+    double index_walk = timer.touch().delta;
+
+    printf("neighbour walk: hash %.3fs, paged %.3fs (%zu/%zu)\n",
+           hash_walk, index_walk, sum, sum2);
+
+    /* 3/ the real consumers */
+    timer.touch();
+    ship->rebuild_topology();
+    printf("rebuild_topology: %.3fs\n", timer.touch().delta);
+
+    raycast_info_block rc;
+    timer.touch();
+    for (int n = 0; n < 100000; n++) {
+        glm::vec3 o(0.5f + (n % extent.x), -10.5f, 0.5f + (n % extent.z));
+        ship->raycast_block(o, glm::vec3(0, 1, 0), extent.y + 20.0f, cross_surface, &rc);
+    }
+    printf("100k long raycasts: %.3fs\n", timer.touch().delta);
+
+    return 0;
+}
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <vector>
+
+#include "../src/mesher.h"
+#include "../src/ship_space.h"
+#include "../src/timer.h"
+
+/* builds the same synthetic ship at whatever CHUNK_SIZE this was compiled
+ * with, and reports the numbers which decide what that size should be:
+ * memory, how many chunk meshes (and so VAOs, buffers and rigid bodies) it
+ * takes, and how long topology rebuilds and remeshing take.
+ *
+ * the build compiles this once per size, as chunk_size_bench_4,
+ * chunk_size_bench_8, ..; run them all to compare.
+ */
+
+/* ship_space wants this from the game; nothing is attached here. */
+void
+remove_ents_from_surface(glm::ivec3, int)
+{
+}
+
+/* 96 x 384 x 32 blocks; a whole number of chunks at every size we try */
+static glm::ivec3 const hull_blocks(96, 384, 32);
+
+static bool
+is_frame(glm::ivec3 p)
+{
+    /* framing on every fourth plane, like bulkheads and decks */
+    return p.x % 4 == 0 || p.y % 4 == 0 || p.z % 4 == 0;
+}
+
+static ship_space *
+build_hull()
+{
+    auto *ship = new ship_space;
+
+    for (int k = 0; k < hull_blocks.z; k++) {
+        for (int j = 0; j < hull_blocks.y; j++) {
+            for (int i = 0; i < hull_blocks.x; i++) {
+                block bl = ship->ensure_block(glm::ivec3(i, j, k));
+                *bl.type = is_frame(glm::ivec3(i, j, k)) ? block_frame : block_empty;
+            }
+        }
+    }
+
+    /* wall off every 16th x plane, so the topology has some rooms to find.
+     * this writes both sides directly rather than going through set_surface,
+     * like any other bulk build -- we rebuild the topology afterwards. */
+    for (int k = 0; k < hull_blocks.z; k++) {
+        for (int j = 0; j < hull_blocks.y; j++) {
+            for (int i = 16; i < hull_blocks.x; i += 16) {
+                block a = ship->get_block(glm::ivec3(i - 1, j, k));
+                block b = ship->get_block(glm::ivec3(i, j, k));
+                a.surfs[surface_xp] = surface_wall;
+                b.surfs[surface_xm] = surface_wall;
+            }
+        }
+    }
+
+    return ship;
+}
+
+/* stand-ins for the real assets, which need a gl context to load: a cube
+ * for every kind of frame, and a quad for every surface. */
+static vertex cube_verts[8];
+static unsigned cube_indices[36] = {
+    0, 2, 1, 1, 2, 3,   4, 5, 6, 5, 7, 6,
+    0, 1, 4, 1, 5, 4,   2, 6, 3, 3, 6, 7,
+    0, 4, 2, 2, 4, 6,   1, 3, 5, 3, 7, 5,
+};
+static vertex quad_verts[4];
+static unsigned quad_indices[6] = { 0, 1, 2, 2, 1, 3 };
+
+static void
+init_sources(mesher_sources *src, sw_mesh *cube, sw_mesh *quad)
+{
+    for (int n = 0; n < 8; n++) {
+        cube_verts[n] = vertex((float)(n & 1), (float)((n >> 1) & 1), (float)(n >> 2), 0, 0, 1, 0, 0);
+    }
+    for (int n = 0; n < 4; n++) {
+        quad_verts[n] = vertex((float)(n & 1), (float)(n >> 1), 0, 0, 0, 1, 0, 0);
+    }
+
+    *cube = sw_mesh{ cube_verts, cube_indices, 8, 36 };
+    *quad = sw_mesh{ quad_verts, quad_indices, 4, 6 };
+
+    *src = mesher_sources{};
+    src->frame = src->frame_corner = src->frame_invcorner = src->frame_sloped = cube;
+    for (auto &s : src->surfs) {
+        s = quad;
+    }
+    for (auto &s : src->phys_surfs) {
+        s = quad;
+    }
+    for (auto &m : src->corner_matrices) m = glm::mat4(1.0f);
+    for (auto &m : src->sloped_matrices) m = glm::mat4(1.0f);
+    for (auto &m : src->extra_matrices) m = glm::mat4(1.0f);
+
+    mesher_bake(src);
+}
+
+int
+main(void)
+{
+    Timer timer;
+
+    timer.touch();
+    ship_space *ship = build_hull();
+    double build_time = timer.touch().delta;
+
+    size_t num_chunks = ship->chunks.size();
+    size_t num_expanded = 0;
+    for (auto ch : ship->chunks) {
+        num_expanded += !ch.second->is_uniform();
+    }
+    size_t block_bytes = num_chunks * sizeof(chunk) + num_expanded * sizeof(chunk_blocks);
+
+    timer.touch();
+    ship->rebuild_topology();
+    double rebuild_time = timer.touch().delta;
+
+    mesher_sources src;
+    sw_mesh cube, quad;
+    init_sources(&src, &cube, &quad);
+
+    chunk_mesh_buffers buf;
+    chunk_shell shell;
+    size_t num_meshes = 0;
+    size_t num_verts = 0;
+    size_t num_tris = 0, num_phys_tris = 0;
+    size_t gpu_bytes = 0;
+
+    timer.touch();
+    for (auto ch : ship->chunks) {
+        chunk *nb[face_count];
+        ship->get_chunk_neighbours(ch.second, nb);
+        shell.fill(nb);
+
+        buf.clear();
+        build_chunk_mesh(ch.second, &shell, &src, &buf);
+        if (!buf.indices.empty()) {
+            num_meshes++;
+            num_verts += buf.num_render_verts;
+            num_tris += buf.indices.size() / 3;
+            num_phys_tris += buf.phys_indices.size() / 3;
+            gpu_bytes += buf.num_render_verts * sizeof(chunk_vertex) +
+                         buf.indices.size() * (buf.short_fits() ? sizeof(uint16_t) : sizeof(unsigned));
+        }
+    }
+    double remesh_time = timer.touch().delta;
+
+    /* and again without the neighbours, so nothing on a chunk's edge is
+     * culled; the difference is what looking across chunks saves */
+    size_t edge_tris = 0;
+    for (auto ch : ship->chunks) {
+        buf.clear();
+        build_chunk_mesh(ch.second, (chunk_shell const *)nullptr, &src, &buf);
+        edge_tris += buf.indices.size() / 3;
+    }
+
+    /* an edit only remeshes the chunk it touched */
+    double per_edit = num_chunks ? remesh_time / num_chunks : 0;
+
+    printf("chunk size %2d: %6zu chunks (%zu bytes each, +%zu if not uniform; %.1f MiB), %6zu meshes, %zu verts\n",
+           CHUNK_SIZE, num_chunks, sizeof(chunk), sizeof(chunk_blocks), block_bytes / (1024.0 * 1024.0),
+           num_meshes, num_verts);
+    printf("               %zu triangles (%zu for physics), %zu without culling across chunks; %.1f MiB to upload\n",
+           num_tris, num_phys_tris, edge_tris, gpu_bytes / (1024.0 * 1024.0));
+    printf("               build %.3fs, rebuild_topology %.3fs, full remesh %.3fs, remesh per edit %.1fus\n",
+           build_time, rebuild_time, remesh_time, per_edit * 1e6);
+
+    return 0;
+}
@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/ship_space.h"
+#include "../src/timer.h"
+
+/* gas flow between zones, at the 15Hz game tick.
+ *
+ * first the flow step alone, on a 16x16x16 lattice of zones each opening
+ * onto its neighbours, with the faces of the lattice open to vacuum: 4096
+ * zones and some 12k openings. gas must never go negative, nor be made
+ * from nothing.
+ *
+ * then a whole ship of 32x32 rooms, each 4x4x4 blocks, with a part open
+ * door through to the next room along each way. only the first room has
+ * any gas to begin with; every tick gathers the zones on either side of
+ * each door again, steps them, and writes the gas back to the zones.
+ */
+
+/* ship_space wants this from the game; nothing is attached here. */
+void
+remove_ents_from_surface(glm::ivec3, int)
+{
+}
+
+static float const dt = 1 / 15.0f;
+
+static void
+bench_lattice()
+{
+    int const n = 16;
+    gas_flow flow;
+
+    flow.add_zone(nullptr, 0, nullptr);
+    for (int i = 0; i < n * n * n; i++) {
+        float gas = float(rand() % 1000);
+        flow.add_zone(nullptr, 64, &gas);
+    }
+
+    for (int z = 0; z < n; z++) {
+        for (int y = 0; y < n; y++) {
+            for (int x = 0; x < n; x++) {
+                unsigned i = 1 + x + n * (y + n * z);
+                glm::ivec3 p(x, y, z);
+                for (int axis = 0; axis < 3; axis++) {
+                    unsigned stride = axis == 0 ? 1 : axis == 1 ? n : n * n;
+                    if (p[axis] + 1 < n) {
+                        flow.add_edge(i, i + stride, 2.0f);
+                    }
+                    if (p[axis] == 0 || p[axis] == n - 1) {
+                        flow.add_edge(i, 0, 0.5f);
+                    }
+                }
+            }
+        }
+    }
+
+    double total = 0;
+    for (auto a : flow.amount[int(gas::oxygen)]) {
+        total += a;
+    }
+
+    int const steps = 1000;
+    bool bad = false;
+    Timer timer;
+    timer.touch();
+
+    for (int s = 0; s < steps; s++) {
+        flow.step(dt);
+    }
+
+    double step_time = timer.touch().delta;
+
+    double after = 0;
+    for (auto a : flow.amount[int(gas::oxygen)]) {
+        bad = bad || a < 0;
+        after += a;
+    }
+    bad = bad || after > total * 1.0001;
+
+    printf("lattice: %u zones, %u openings: %.1fus a step; %.0f of %.0f gas left after %d steps%s\n",
+           flow.num_zones(), flow.num_edges(), step_time * 1e6 / steps, after, total, steps,
+           bad ? " -- WRONG" : "");
+}
+
+/* wall the box lo..hi (inclusive) in from the inside */
+static void
+build_box(ship_space *ship, glm::ivec3 lo, glm::ivec3 hi)
+{
+    for (int axis = 0; axis < 3; axis++) {
+        int u = (axis + 1) % 3, v = (axis + 2) % 3;
+        for (int i = lo[u]; i <= hi[u]; i++) {
+            for (int j = lo[v]; j <= hi[v]; j++) {
+                glm::ivec3 p;
+                p[u] = i;
+                p[v] = j;
+
+                p[axis] = lo[axis];
+                glm::ivec3 q = p;
+                q[axis]--;
+                ship->set_surface(p, q, (surface_index)(2 * axis + 1), surface_wall);
+
+                p[axis] = hi[axis];
+                q = p;
+                q[axis]++;
+                ship->set_surface(p, q, (surface_index)(2 * axis), surface_wall);
+            }
+        }
+    }
+}
+
+static void
+bench_ship()
+{
+    int const rooms = 32, size = 4;
+    auto *ship = new ship_space;
+    ship->rebuild_topology();
+
+    Timer timer;
+    timer.touch();
+
+    ship->begin_edit();
+    for (int j = 0; j < rooms; j++) {
+        for (int i = 0; i < rooms; i++) {
+            glm::ivec3 lo(1 + i * size, 1 + j * size, 1);
+            build_box(ship, lo, lo + glm::ivec3(size - 1));
+        }
+    }
+
+    /* a door in the middle of each room's +x and +y walls */
+    std::vector<glm::ivec3> doors[2];
+    for (int j = 0; j < rooms; j++) {
+        for (int i = 0; i < rooms; i++) {
+            glm::ivec3 mid(1 + i * size + size / 2, 1 + j * size + size / 2, 1);
+            for (int axis = 0; axis < 2; axis++) {
+                if ((axis ? j : i) == rooms - 1) {
+                    continue;
+                }
+
+                glm::ivec3 p = mid;
+                p[axis] = 1 + (axis ? j : i) * size + size - 1;
+                glm::ivec3 q = p;
+                q[axis]++;
+                ship->set_surface(p, q, (surface_index)(2 * axis), surface_door);
+                doors[axis].push_back(p);
+            }
+        }
+    }
+    ship->commit_edit();
+    double build_time = timer.touch().delta;
+
+    zone_info z{};
+    z.gas_amount[int(gas::oxygen)] = 1000.0f * size * size * size;
+    ship->insert_zone(topo_find(ship->get_topo_info(glm::ivec3(1))), z);
+
+    printf("ship: %d rooms, %zu doors; built in %.2fs\n",
+           rooms * rooms, doors[0].size() + doors[1].size(), build_time);
+
+    int const ticks = 150;
+    timer.touch();
+
+    for (int s = 0; s < ticks; s++) {
+        ship->openings.clear();
+        for (int axis = 0; axis < 2; axis++) {
+            for (auto p : doors[axis]) {
+                ship->add_opening(p, 2 * axis, 0.5f);
+            }
+        }
+
+        ship->tick_gas_flow(dt);
+    }
+
+    double tick_time = timer.touch().delta;
+
+    double total = 0;
+    ship->for_each_zone([&](topo_info *, zone_info &z) {
+        total += z.gas_amount[int(gas::oxygen)];
+    });
+
+    topo_info *far = topo_find(ship->get_topo_info(glm::ivec3(rooms * size - 1, rooms * size - 1, 1)));
+    zone_info *fz = ship->get_zone_info(far);
+
+    printf("ship: %u zones, %u openings: %.1fus a tick; %zu zones with gas, %.0f in all, %g in the far corner\n",
+           ship->flow.num_zones(), ship->flow.num_edges(), tick_time * 1e6 / ticks, ship->zone_count(),
+           total, fz ? fz->gas_amount[int(gas::oxygen)] : 0.0f);
+
+    delete ship;
+}
+
+int
+main(void)
+{
+    srand(1);
+
+    bench_lattice();
+    bench_ship();
+
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/ship_space.h"
+#include "../src/timer.h"
+
+/* per-block pressure through a decompression.
+ *
+ * a long hall, 8x8 blocks across and 256 long, full of gas and walled in
+ * all round, has the wall at one end cut open to vacuum. the zone empties
+ * at once; the field then carries the pressure the blocks still had down
+ * to the breach. prints the pressure near the breach, halfway along and
+ * at the far end every so often, with how many chunks the field covers
+ * and what a tick cost. once all has settled the field should cover
+ * nothing at all.
+ */
+
+/* ship_space wants this from the game; nothing is attached here. */
+void
+remove_ents_from_surface(glm::ivec3, int)
+{
+}
+
+static float const dt = 1 / 15.0f;
+
+/* wall the box lo..hi (inclusive) in from the inside */
+static void
+build_box(ship_space *ship, glm::ivec3 lo, glm::ivec3 hi)
+{
+    for (int axis = 0; axis < 3; axis++) {
+        int u = (axis + 1) % 3, v = (axis + 2) % 3;
+        for (int i = lo[u]; i <= hi[u]; i++) {
+            for (int j = lo[v]; j <= hi[v]; j++) {
+                glm::ivec3 p;
+                p[u] = i;
+                p[v] = j;
+
+                p[axis] = lo[axis];
+                glm::ivec3 q = p;
+                q[axis]--;
+                ship->set_surface(p, q, (surface_index)(2 * axis + 1), surface_wall);
+
+                p[axis] = hi[axis];
+                q = p;
+                q[axis]++;
+                ship->set_surface(p, q, (surface_index)(2 * axis), surface_wall);
+            }
+        }
+    }
+}
+
+int
+main(void)
+{
+    int const width = 8, length = 256;
+    auto *ship = new ship_space;
+    ship->rebuild_topology();
+    ship->field.enabled = true;
+
+    glm::ivec3 lo(1, 1, 1);
+    glm::ivec3 hi(length, width, width);
+    build_box(ship, lo, hi);
+
+    topo_info *hall = topo_find(ship->get_topo_info(lo));
+    zone_info z{};
+    z.gas_amount[int(gas::oxygen)] = 1.0f * hall->size;
+    ship->insert_zone(hall, z);
+
+    glm::ivec3 near(2, width / 2, width / 2);
+    glm::ivec3 mid(length / 2, width / 2, width / 2);
+    glm::ivec3 far(length, width / 2, width / 2);
+
+    /* breach the -x end */
+    Timer timer;
+    timer.touch();
+    for (int y = lo.y; y <= hi.y; y++) {
+        for (int z = lo.z; z <= hi.z; z++) {
+            glm::ivec3 p(lo.x, y, z);
+            ship->set_surface(p, p - glm::ivec3(1, 0, 0), surface_xm, surface_none);
+        }
+    }
+    double breach_time = timer.touch().delta;
+
+    printf("hall: %dx%dx%d blocks; breached in %.2fms, %zu chunks seeded\n",
+           length, width, width, breach_time * 1e3, ship->field.chunks.size());
+
+    int const ticks = 15 * 60;
+    double total = 0, worst = 0;
+    int settled = -1;
+
+    for (int s = 0; s < ticks; s++) {
+        timer.touch();
+        ship->tick_gas_flow(dt);
+        ship->field.step(ship, dt);
+        double t = timer.touch().delta;
+        total += t;
+        worst = std::max(worst, t);
+
+        if (s % 75 == 0) {
+            printf("  %5.1fs: %4zu chunks, %.1fus; near %.3f mid %.3f far %.3f\n",
+                   s * dt, ship->field.chunks.size(), t * 1e6,
+                   ship->pressure_at(near), ship->pressure_at(mid), ship->pressure_at(far));
+        }
+
+        if (settled < 0 && ship->field.chunks.empty()) {
+            settled = s;
+        }
+    }
+
+    printf("hall: %.1fus a tick on average, %.1fus at worst; ", total * 1e6 / ticks, worst * 1e6);
+    if (settled >= 0) {
+        printf("settled after %.1fs\n", settled * dt);
+    }
+    else {
+        printf("still %zu chunks covered after %.1fs\n", ship->field.chunks.size(), ticks * dt);
+    }
+
+    delete ship;
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "../src/block_cursor.h"
+#include "../src/ship_space.h"
+#include "../src/timer.h"
+
+/* compares ship_space::raycast_block, which runs straight through chunks
+ * the ray can't stop in, against the plain block-by-block walk it
+ * replaced. the ship is two hollow modules with open space between them,
+ * so long rays spend most of their length in missing or uniform chunks.
+ * every ray is also checked to give exactly the same result both ways.
+ */
+
+/* ship_space wants this from the game; nothing is attached here. */
+void
+remove_ents_from_surface(glm::ivec3, int)
+{
+}
+
+static float
+max_along_axis(float o, float d)
+{
+    if (d > 0) {
+        return fabsf((ceilf(o) - o)/d);
+    }
+    else {
+        return fabsf((floorf(o) - o)/d);
+    }
+}
+
+/* the previous raycast_block, a step and a block fetch for every cell */
+static bool
+reference_raycast(ship_space *ship, glm::vec3 o, glm::vec3 d, float max_reach_distance,
+                  raycast_stopping_rule stopping_rule, raycast_info_block *rc)
+{
+    rc->hit = false;
+    rc->t = 0.0f;
+
+    int x = (int)(o.x < 0 ? o.x - 1: o.x);
+    int y = (int)(o.y < 0 ? o.y - 1: o.y);
+    int z = (int)(o.z < 0 ? o.z - 1: o.z);
+
+    int nx = 0;
+    int ny = 0;
+    int nz = 0;
+
+    const_block bl;
+
+    block_cursor cur(ship, glm::ivec3(x, y, z));
+    bl = cur.get();
+    rc->inside = bl ? *bl.type != block_empty && *bl.type != block_untouched : false;
+
+    int stepX = d.x > 0 ? 1 : -1;
+    int stepY = d.y > 0 ? 1 : -1;
+    int stepZ = d.z > 0 ? 1 : -1;
+
+    float tDeltaX = fabsf(1/d.x);
+    float tDeltaY = fabsf(1/d.y);
+    float tDeltaZ = fabsf(1/d.z);
+
+    float tMaxX = max_along_axis(o.x, d.x);
+    float tMaxY = max_along_axis(o.y, d.y);
+    float tMaxZ = max_along_axis(o.z, d.z);
+    float t = 0;
+
+    while (t < max_reach_distance) {
+        if (tMaxX < tMaxY) {
+            if (tMaxX < tMaxZ) {
+                x += stepX; cur.step(0, stepX);
+                t = tMaxX; tMaxX += tDeltaX;
+                nx = -stepX; ny = 0; nz = 0;
+            }
+            else {
+                z += stepZ; cur.step(2, stepZ);
+                t = tMaxZ; tMaxZ += tDeltaZ;
+                nx = 0; ny = 0; nz = -stepZ;
+            }
+        }
+        else {
+            if (tMaxY < tMaxZ) {
+                y += stepY; cur.step(1, stepY);
+                t = tMaxY; tMaxY += tDeltaY;
+                nx = 0; ny = -stepY; nz = 0;
+            }
+            else {
+                z += stepZ; cur.step(2, stepZ);
+                t = tMaxZ; tMaxZ += tDeltaZ;
+                nx = 0; ny = 0; nz = -stepZ;
+            }
+        }
+
+        bl = cur.get();
+        if (!bl && !rc->inside) {
+            continue;
+        }
+
+        bool stop = false;
+        if (stopping_rule & enter_exit_framing) {
+            stop = rc->inside ^ (bl && *bl.type != block_empty && *bl.type != block_untouched);
+        }
+        if (!stop && (stopping_rule & cross_surface)) {
+            stop = bl && bl.surfs[normal_to_surface_index(nx, ny, nz)];
+        }
+
+        if (stop) {
+            rc->hit = true;
+            rc->bl = glm::ivec3(x, y, z);
+            rc->block = bl;
+            rc->n = glm::ivec3(nx, ny, nz);
+            rc->p = rc->bl + rc->n;
+            rc->t = t;
+            rc->hitCoord = o + rc->t * d;
+            return true;
+        }
+    }
+    return rc->hit;
+}
+
+/* a hollow box of framing, walled on the outside, with a deck every 8
+ * blocks. the space inside is never touched, so it stays uniform. */
+static void
+build_module(ship_space *ship, glm::ivec3 base, glm::ivec3 size)
+{
+    for (int k = 0; k < size.z; k++) {
+        for (int j = 0; j < size.y; j++) {
+            for (int i = 0; i < size.x; i++) {
+                bool shell = i == 0 || j == 0 || k == 0 ||
+                    i == size.x - 1 || j == size.y - 1 || k == size.z - 1;
+                bool deck = k % 8 == 0;
+                if (!shell && !deck) {
+                    continue;
+                }
+
+                glm::ivec3 p = base + glm::ivec3(i, j, k);
+                *ship->ensure_block(p).type = block_frame;
+
+                if (i == 0) ship->set_surface(p, p + glm::ivec3(-1, 0, 0), surface_xm, surface_wall);
+                if (j == 0) ship->set_surface(p, p + glm::ivec3(0, -1, 0), surface_ym, surface_wall);
+                if (k == 0) ship->set_surface(p, p + glm::ivec3(0, 0, -1), surface_zm, surface_wall);
+            }
+        }
+    }
+}
+
+static float
+frand(float lo, float hi)
+{
+    return lo + (hi - lo) * (rand() / (float)RAND_MAX);
+}
+
+struct ray {
+    glm::vec3 o, d;
+    raycast_stopping_rule rule;
+};
+
+int
+main(void)
+{
+    auto *ship = new ship_space;
+    ship->rebuild_topology();
+
+    ship->begin_edit();
+    build_module(ship, glm::ivec3(0, 0, 0), glm::ivec3(64, 128, 33));
+    build_module(ship, glm::ivec3(0, 256, 0), glm::ivec3(64, 64, 33));
+    ship->commit_edit();
+
+    size_t uniform = 0;
+    for (auto ch : ship->chunks) {
+        uniform += ch.second->is_uniform();
+    }
+    printf("ship: %zu chunks, %zu uniform\n", ship->chunks.size(), uniform);
+
+    std::vector<ray> rays;
+    srand(1);
+    for (int n = 0; n < 200000; n++) {
+        ray r;
+        r.o = glm::vec3(frand(-40, 100), frand(-40, 360), frand(-20, 50));
+        r.d = glm::normalize(glm::vec3(frand(-1, 1), frand(-1, 1), frand(-1, 1)));
+        if (n % 4 == 0) {
+            /* some axis-aligned, as tools often are */
+            r.d = glm::vec3(0, n % 8 ? 1 : -1, 0);
+        }
+        r.rule = (raycast_stopping_rule)(n % 3 + 1);
+        rays.push_back(r);
+    }
+
+    float const reach = 400.0f;
+    std::vector<raycast_info_block> a(rays.size()), b(rays.size());
+
+    Timer timer;
+    timer.touch();
+    for (size_t n = 0; n < rays.size(); n++) {
+        reference_raycast(ship, rays[n].o, rays[n].d, reach, rays[n].rule, &a[n]);
+    }
+    double ref_time = timer.touch().delta;
+
+    for (size_t n = 0; n < rays.size(); n++) {
+        ship->raycast_block(rays[n].o, rays[n].d, reach, rays[n].rule, &b[n]);
+    }
+    double new_time = timer.touch().delta;
+
+    size_t hits = 0, mismatches = 0;
+    for (size_t n = 0; n < rays.size(); n++) {
+        hits += a[n].hit;
+        bool same = a[n].hit == b[n].hit && a[n].inside == b[n].inside;
+        if (same && a[n].hit) {
+            same = a[n].bl == b[n].bl && a[n].n == b[n].n && a[n].p == b[n].p &&
+                (bool)a[n].block == (bool)b[n].block &&
+                (!a[n].block || *a[n].block.type == *b[n].block.type) &&
+                memcmp(&a[n].t, &b[n].t, sizeof(float)) == 0 &&
+                memcmp(&a[n].hitCoord, &b[n].hitCoord, sizeof(glm::vec3)) == 0;
+        }
+        mismatches += !same;
+    }
+
+    printf("%zu rays of reach %.0f (%zu hits): block walk %.3fs, chunk skipping %.3fs, %zu mismatches\n",
+           rays.size(), reach, hits, ref_time, new_time, mismatches);
+
+    return mismatches != 0;
+}
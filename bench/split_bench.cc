@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/ship_space.h"
+#include "../src/timer.h"
+
+/* sealing a door between a big hall and a small room, against the full
+ * topology rebuild which used to follow every split. the hall is 64x64x32
+ * blocks, mostly untouched uniform chunks; the room is 4x4x4 off one end.
+ * the door is opened and sealed over and over, and after every seal both
+ * sides are checked for the right size and share of the gas.
+ *
+ * then a wall right across a hall with every chunk expanded, cutting it in
+ * two halves of the same size, so that neither can be avoided.
+ */
+
+/* ship_space wants this from the game; nothing is attached here. */
+void
+remove_ents_from_surface(glm::ivec3, int)
+{
+}
+
+/* wall the box lo..hi (inclusive) in from the inside */
+static void
+build_box(ship_space *ship, glm::ivec3 lo, glm::ivec3 hi)
+{
+    for (int axis = 0; axis < 3; axis++) {
+        int u = (axis + 1) % 3, v = (axis + 2) % 3;
+        for (int i = lo[u]; i <= hi[u]; i++) {
+            for (int j = lo[v]; j <= hi[v]; j++) {
+                glm::ivec3 p;
+                p[u] = i;
+                p[v] = j;
+
+                p[axis] = lo[axis];
+                glm::ivec3 q = p;
+                q[axis]--;
+                ship->set_surface(p, q, (surface_index)(2 * axis + 1), surface_wall);
+
+                p[axis] = hi[axis];
+                q = p;
+                q[axis]++;
+                ship->set_surface(p, q, (surface_index)(2 * axis), surface_wall);
+            }
+        }
+    }
+}
+
+int
+main(void)
+{
+    auto *ship = new ship_space;
+    ship->rebuild_topology();
+
+    glm::ivec3 hall_lo(1, 1, 1), hall_hi(64, 64, 32);
+    glm::ivec3 room_lo(65, 30, 1), room_hi(68, 33, 4);
+
+    ship->begin_edit();
+    build_box(ship, hall_lo, hall_hi);
+    build_box(ship, room_lo, room_hi);
+    ship->commit_edit();
+    ship->rebuild_topology();
+
+    glm::ivec3 door(64, 31, 2), door_far(65, 31, 2);
+    glm::ivec3 in_hall(10, 10, 10), in_room(66, 31, 2);
+
+    auto hall_size = topo_find(ship->get_topo_info(in_hall))->size;
+    auto room_size = topo_find(ship->get_topo_info(in_room))->size;
+    printf("ship: %zu chunks, hall %d blocks, room %d blocks\n", ship->chunks.size(), hall_size, room_size);
+
+    zone_info z{};
+    z.gas_amount[int(gas::oxygen)] = 1000.0f;
+    ship->insert_zone(topo_find(ship->get_topo_info(in_hall)), z);
+
+    int const rounds = 2000;
+    int bad = 0;
+    Timer timer;
+    double seal_time = 0, rebuild_time = 0;
+    int visits = ship->num_split_visits;
+
+    for (int n = 0; n < rounds; n++) {
+        ship->set_surface(door, door_far, surface_xp, surface_none);
+
+        timer.touch();
+        ship->set_surface(door, door_far, surface_xp, surface_wall);
+        seal_time += timer.touch().delta;
+
+        topo_info *h = topo_find(ship->get_topo_info(in_hall));
+        topo_info *r = topo_find(ship->get_topo_info(in_room));
+        zone_info *hz = ship->get_zone_info(h), *rz = ship->get_zone_info(r);
+        bad += h == r || h->size != hall_size || r->size != room_size || !hz || !rz;
+    }
+    visits = ship->num_split_visits - visits;
+
+    /* what each of those seals used to cost */
+    for (int n = 0; n < 20; n++) {
+        timer.touch();
+        ship->rebuild_topology();
+        rebuild_time += timer.touch().delta;
+    }
+
+    float total = 0;
+    ship->for_each_zone([&](topo_info *, zone_info &zone) {
+        total += zone.gas_amount[int(gas::oxygen)];
+    });
+
+    printf("%d seals: %.6fs each, %.1f nodes visited each; full rebuild %.6fs\n",
+           rounds, seal_time / rounds, (double)visits / rounds, rebuild_time / 20);
+    printf("gas total %.2f, %d bad seals\n", total, bad);
+
+    auto *big = new ship_space;
+    big->rebuild_topology();
+
+    glm::ivec3 big_lo(0, 0, 0), big_hi(63, 63, 63);
+    big->begin_edit();
+    build_box(big, big_lo, big_hi);
+    for (int z = big_lo.z; z <= big_hi.z; z++) {
+        for (int y = big_lo.y; y <= big_hi.y; y++) {
+            for (int x = big_lo.x; x <= big_hi.x; x++) {
+                *big->ensure_block(glm::ivec3(x, y, z)).type = block_frame;
+            }
+        }
+    }
+    big->commit_edit();
+    big->rebuild_topology();
+
+    int const cuts = 20;
+    double cut_time = 0;
+    visits = big->num_split_visits;
+
+    for (int n = 0; n < cuts; n++) {
+        for (auto st : { surface_wall, surface_none }) {
+            timer.touch();
+            big->begin_edit();
+            for (int z = big_lo.z; z <= big_hi.z; z++) {
+                for (int y = big_lo.y; y <= big_hi.y; y++) {
+                    big->set_surface(glm::ivec3(31, y, z), glm::ivec3(32, y, z), surface_xp, st);
+                }
+            }
+            big->commit_edit();
+            if (st == surface_wall) {
+                cut_time += timer.touch().delta;
+                bad += topo_find(big->get_topo_info(glm::ivec3(0, 0, 0)))->size != 32 * 64 * 64;
+            }
+        }
+    }
+    visits = big->num_split_visits - visits;
+
+    printf("%d cuts of an expanded 64^3 hall in half: %.6fs each, %.1f nodes visited each, %d bad\n",
+           cuts, cut_time / cuts, (double)visits / cuts, bad);
+
+    return bad != 0;
+}
@@ -23,6 +23,7 @@
 #include "src/component/component_system_manager.h"
 #include "src/config.h"
 #include "src/input.h"
+#include "src/mesher.h"
 #include "src/mesh.h"
 #include "src/physics.h"
 #include "src/player.h"
@@ -64,6 +65,7 @@ bool draw_debug_chunks = false;
 bool draw_debug_axis = false;
 bool draw_debug_physics = false;
 bool draw_fps = false;
+bool pressure_field_mode = false;
 
 en_settings game_settings;
 
@@ -158,38 +160,62 @@ set_game_state()
     }
 }
 
+chunk_mesh_queue chunk_meshes;
+
+/* remesh the chunks which have changed on the mesher's workers, and put
+ * in place whatever they have finished. with wait, everything is in place
+ * before this returns. */
 void
-prepare_chunks()
+prepare_chunks(bool wait)
 {
     /* walk all the chunks -- TODO: only walk chunks that might contribute to the view */
-    for (int k = ship->mins.z; k <= ship->maxs.z; k++) {
-        for (int j = ship->mins.y; j <= ship->maxs.y; j++) {
-            for (int i = ship->mins.x; i <= ship->maxs.x; i++) {
-                chunk *ch = ship->get_chunk(glm::ivec3(i, j, k));
-                if (ch) {
-                    ch->prepare_render();
-                    ch->prepare_phys(i, j, k);
-                }
-            }
+    for (auto c : ship->chunks) {
+        chunk *ch = c.second;
+        if (!chunk_meshes.wants(ch)) {
+            continue;
         }
+
+        chunk *nb[face_count];
+        ship->get_chunk_neighbours(ch, nb);
+        chunk_meshes.submit(ch, nb);
     }
+
+    chunk_meshes.land(wait);
 }
 
 void
 teardown_chunks()
 {
-    for (int k = ship->mins.z; k <= ship->maxs.z; k++) {
-        for (int j = ship->mins.y; j <= ship->maxs.y; j++) {
-            for (int i = ship->mins.x; i <= ship->maxs.x; i++) {
-                chunk *ch = ship->get_chunk(glm::ivec3(i, j, k));
-                if (ch) {
-                    teardown_physics_setup(&ch->phys_chunk.phys_mesh, &ch->phys_chunk.phys_shape, &ch->phys_chunk.phys_body);
-                }
-            }
+    /* nothing may still be working on these chunks */
+    chunk_meshes.land(true);
+
+    for (auto ch : ship->chunks) {
+        teardown_physics_setup(&ch.second->phys_chunk.phys_mesh, &ch.second->phys_chunk.phys_shape,
+                               &ch.second->phys_chunk.phys_body);
+
+        /* the chunks go with the ship, but their meshes are ours */
+        if (ch.second->render_chunk.mesh) {
+            free_mesh(ch.second->render_chunk.mesh);
+            delete ch.second->render_chunk.mesh;
+            ch.second->render_chunk.mesh = nullptr;
         }
     }
 }
 
+/* swap in a whole new ship. its chunks are meshed before this returns, so
+ * that it is solid from the first frame, and the entities still attached
+ * to surfaces are filed in its index of them */
+void
+replace_ship(ship_space *new_ship)
+{
+    teardown_chunks();
+    delete ship;
+    ship = new_ship;
+
+    index_attached_entities(ship);
+    prepare_chunks(true);
+}
+
 GLuint render_displays_fbo{ 0 };
 
 ImGuiContext *default_context;
@@ -267,6 +293,7 @@ init()
 
     // must be called after asset_man is setup
     mesher_init();
+    chunk_meshes.start();
 
     simple_shader = load_shader("shaders/chunk.vert", "shaders/chunk.frag");
     overlay_shader = load_shader("shaders/overlay.vert", "shaders/overlay.frag");
@@ -323,7 +350,7 @@ init()
     printf("World vertex size: %zu bytes\n", sizeof(vertex));
 
     /* prepare the chunks -- this populates the physics data */
-    prepare_chunks();
+    prepare_chunks(true);
 
     /* raw palette tex -- bind and leave it bound */
     /* TODO: generalize texture_set so it can do this nicely. */
@@ -350,10 +377,8 @@ init()
     save(ship, "ship.out");
     auto new_ship = new ship_space();
     load(new_ship, "ship.out");
-    teardown_chunks();
-    delete ship;
-    ship = new_ship;
-    ship->rebuild_topology();
+    new_ship->rebuild_topology();
+    replace_ship(new_ship);
 }
 
 void
@@ -458,19 +483,13 @@ update_display_contents()
 void
 remove_ents_from_surface(glm::ivec3 b, int face)
 {
-    auto &surface_man = component_system_man.managers.surface_attachment_component_man;
+    /* popping can destroy and respawn entities, so take the list first */
+    std::vector<c_entity> ents;
+    ship->entities_on_surface(b, face, ents);
 
-    for (auto i = 0u; i < surface_man.buffer.num; i++) {
-        auto ce = surface_man.instance_pool.entity[i];
-
-        auto p = surface_man.instance_pool.block[i];
-        auto f = surface_man.instance_pool.face[i];
-        auto attached = surface_man.instance_pool.attached[i];
-
-        // TODO: consider multiple attachment points?
-        if (attached && p == b && f == face) {
-            pop_entity_off(ce);
-        }
+    // TODO: consider multiple attachment points?
+    for (auto ce : ents) {
+        pop_entity_off(ce);
     }
 }
 
@@ -559,47 +578,29 @@ void draw_wires() {
         &asset_man.get_mesh("wire_endi"),
     };
 
-    for (int k = ship->mins.z; k <= ship->maxs.z; k++) {
-        for (int j = ship->mins.y; j <= ship->maxs.y; j++) {
-            for (int i = ship->mins.x; i <= ship->maxs.x; i++) {
-                chunk *ch = ship->get_chunk(glm::ivec3(i, j, k));
-                if (ch) {
-                    for (int z = 0; z < CHUNK_SIZE; z++) {
-                        for (int y = 0; y < CHUNK_SIZE; y++) {
-                            for (int x = 0; x < CHUNK_SIZE; x++) {
-                                auto bl = ch->blocks.get(x, y, z);
-
-                                auto meshes = bl->type == block_frame ? inside_meshes : outside_meshes;
-
-                                for (int face = 0; face < 6; face++) {
-                                    if (bl->has_wire[face]) {
-                                        auto params = frame->alloc_aligned<glm::mat4>(1);
-                                        *(params.ptr) = mat_block_face(glm::vec3(i * CHUNK_SIZE + x, j * CHUNK_SIZE + y, k * CHUNK_SIZE + z), face);
-                                        params.bind(1, frame);
-
-                                        auto bits = shuffle_adj_bits_for_face(bl->wire_bits[face], face);
-
-                                        if (bits & 1)
-                                            draw_mesh(meshes[0]->hw);
-                                        if (bits & 2)
-                                            draw_mesh(meshes[1]->hw);
-                                        if (bits & 4)
-                                            draw_mesh(meshes[2]->hw);
-                                        if (bits & 8)
-                                            draw_mesh(meshes[3]->hw);
-
-                                        if (!(bits & (bits - 1))) {
-                                            draw_mesh(meshes[4]->hw);
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+    ship->for_each_wire(CHUNK_SIZE * ship->mins, CHUNK_SIZE * ship->maxs + glm::ivec3(CHUNK_SIZE - 1),
+                        [&](glm::ivec3 pos, int face, block bl) {
+        auto meshes = *bl.type == block_frame ? inside_meshes : outside_meshes;
+
+        auto params = frame->alloc_aligned<glm::mat4>(1);
+        *(params.ptr) = mat_block_face(glm::vec3(pos), face);
+        params.bind(1, frame);
+
+        auto bits = shuffle_adj_bits_for_face(bl.wire_bits[face], face);
+
+        if (bits & 1)
+            draw_mesh(meshes[0]->hw);
+        if (bits & 2)
+            draw_mesh(meshes[1]->hw);
+        if (bits & 4)
+            draw_mesh(meshes[2]->hw);
+        if (bits & 8)
+            draw_mesh(meshes[3]->hw);
+
+        if (!(bits & (bits - 1))) {
+            draw_mesh(meshes[4]->hw);
         }
-    }
+    });
 }
 
 glm::vec3 fp_item_offset{ 0.115f, 0.2f, -0.12f };
@@ -650,7 +651,7 @@ void render() {
     camera_params.ptr->time = (float)frame_info.elapsed;
     camera_params.bind(0, frame);
 
-    prepare_chunks();
+    prepare_chunks(false);
 
     glUseProgram(simple_shader);
 
@@ -662,9 +663,15 @@ void render() {
                 if (ch) {
                     auto chunk_matrix = frame->alloc_aligned<glm::mat4>(1);
                     auto p = glm::vec3(CHUNK_SIZE * glm::ivec3(i, j, k));
-                    *chunk_matrix.ptr = mat_position(p);
+                    /* chunk meshes are in fixed point, see chunk_vertex */
+                    *chunk_matrix.ptr = glm::scale(mat_position(p), glm::vec3(1.0f / chunk_vertex_scale));
                     chunk_matrix.bind(1, frame);
-                    draw_mesh(ch->render_chunk.mesh);
+
+                    /* a chunk made during play has nothing to draw until
+                     * its first mesh lands */
+                    if (ch->render_chunk.mesh) {
+                        draw_mesh(ch->render_chunk.mesh);
+                    }
 
                     if (draw_debug_chunks) {
                         ddVec3 dv{p.x + CHUNK_SIZE / 2, p.y + CHUNK_SIZE / 2, p.z + CHUNK_SIZE / 2};
@@ -786,15 +793,13 @@ update()
     /* things that can run at a pretty slow rate */
     while (main_tick_accum.tick()) {
 
-        /* remove any air that someone managed to get into the outside */
-        {
-            topo_info *t = topo_find(&ship->outside_topo_info);
-            zone_info *z = ship->get_zone_info(t);
-            if (z) {
-                /* try as hard as you like, you cannot fill space with your air system */
-                *z = {};
-            }
-        }
+        /* move gas between zones through open doors, and out to vacuum */
+        tick_door_openings(ship);
+        ship->tick_gas_flow(main_tick_accum.period);
+
+        /* and within zones, in per-block pressure mode */
+        ship->field.enabled = pressure_field_mode;
+        ship->field.step(ship, main_tick_accum.period);
 
         /* allow the entities to tick */
         tick_gas_producers(ship);
@@ -1017,6 +1022,8 @@ main(int, char **)
 
     run();
 
+    chunk_meshes.stop();
+
     ImGui_ImplSdlGL3_Shutdown();
 
     audio->deinit();
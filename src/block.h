@@ -1,6 +1,6 @@
 #pragma once
 
-enum block_type {
+enum block_type : unsigned char {
     block_untouched,
     block_empty,
     block_frame,
@@ -51,13 +51,77 @@ enum surface_index : unsigned {
 /* a single block
  * represents a 1m^3 cube
  * for more information see docs/ships-space.md
+ *
+ * the block's data lives in per-attribute planes in its chunk; a block is
+ * just the set of pointers to its slot in each plane, much like a
+ * component's instance_data. a default-constructed block refers to
+ * nothing, and tests false -- this is what get_block() returns outside
+ * the ship.
  */
 struct block {
-    block_type type = block_untouched;
+    block_type *type = nullptr;
+    surface_type *surfs = nullptr;          /* [face_count] */
+    unsigned char *wire_mask = nullptr;     /* bit per face: is there wire on it */
+    unsigned char *wire_bits = nullptr;     /* [face_count] adjacency bits of that wire */
+
+    block() = default;
+
+    block(block_type *type, surface_type *surfs, unsigned char *wire_mask, unsigned char *wire_bits)
+        : type(type), surfs(surfs), wire_mask(wire_mask), wire_bits(wire_bits)
+    {
+    }
+
+    explicit operator bool() const
+    {
+        return type != nullptr;
+    }
+
+    bool has_wire(int face) const
+    {
+        return (*wire_mask >> face) & 1;
+    }
+
+    void set_has_wire(int face, bool w)
+    {
+        if (w)
+            *wire_mask |= 1 << face;
+        else
+            *wire_mask &= ~(1 << face);
+    }
+};
+
+/* as block, but only for reading. this is what peek_block() returns: in a
+ * uniform chunk it refers to shared, read-only storage, so a write through
+ * it must not compile. any block converts to one.
+ */
+struct const_block {
+    block_type const *type = nullptr;
+    surface_type const *surfs = nullptr;
+    unsigned char const *wire_mask = nullptr;
+    unsigned char const *wire_bits = nullptr;
+
+    const_block() = default;
+
+    const_block(block_type const *type, surface_type const *surfs,
+                unsigned char const *wire_mask, unsigned char const *wire_bits)
+        : type(type), surfs(surfs), wire_mask(wire_mask), wire_bits(wire_bits)
+    {
+    }
+
+    const_block(block const &b)
+        : type(b.type), surfs(b.surfs), wire_mask(b.wire_mask), wire_bits(b.wire_bits)
+    {
+    }
+
+    explicit operator bool() const
+    {
+        return type != nullptr;
+    }
 
-    surface_type surfs[face_count]{};
-    bool has_wire[face_count]{};
-    unsigned wire_bits[face_count]{};
+    bool has_wire(int face) const
+    {
+        return (*wire_mask >> face) & 1;
+    }
 };
 
 static inline unsigned char  /* bool */
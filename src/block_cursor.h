@@ -0,0 +1,104 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "block.h"
+#include "chunk.h"
+#include "ship_space.h"
+
+/* a position within a ship_space which remembers the chunk it is in
+ *
+ * get_block() has to split all three coordinates and look up the chunk on
+ * every call, even when walking to the next block over. a cursor does that
+ * once, and then stepping one block along an axis only touches the chunk
+ * index when the step crosses a chunk boundary.
+ *
+ * like get_block(), a cursor outside any chunk is fine -- get() and
+ * topo() then give null and the outside node respectively.
+ */
+struct block_cursor {
+    ship_space *ship;
+    glm::ivec3 pos;         /* block coordinates */
+    glm::ivec3 chunk_pos;   /* chunk coordinates of the chunk containing pos */
+    glm::ivec3 local;       /* offset of pos within that chunk */
+    chunk *ch;              /* may be null */
+
+    block_cursor(ship_space *ship, glm::ivec3 p)
+        : ship(ship)
+    {
+        seek(p);
+    }
+
+    /* jump to an arbitrary block */
+    void seek(glm::ivec3 p)
+    {
+        pos = p;
+        split_coord(p.x, &local.x, &chunk_pos.x);
+        split_coord(p.y, &local.y, &chunk_pos.y);
+        split_coord(p.z, &local.z, &chunk_pos.z);
+        ch = ship->get_chunk(chunk_pos);
+    }
+
+    /* move d (+1 or -1) blocks along axis (0, 1, 2 for x, y, z) */
+    void step(int axis, int d)
+    {
+        pos[axis] += d;
+        local[axis] += d;
+
+        if (local[axis] < 0 || local[axis] >= CHUNK_SIZE) {
+            local[axis] -= d * CHUNK_SIZE;
+            chunk_pos[axis] += d;
+            ch = ship->get_chunk(chunk_pos);
+        }
+    }
+
+    /* move to the neighbour across surface index face */
+    void step(int face)
+    {
+        step(face >> 1, (face & 1) ? -1 : 1);
+    }
+
+    /* move by an arbitrary offset; unit offsets along each axis stay cheap */
+    void step(glm::ivec3 d)
+    {
+        if (glm::any(glm::greaterThan(glm::abs(d), glm::ivec3(1)))) {
+            seek(pos + d);
+            return;
+        }
+
+        for (int axis = 0; axis < 3; axis++) {
+            if (d[axis]) {
+                step(axis, d[axis]);
+            }
+        }
+    }
+
+    /* a cursor at the neighbour across surface index face */
+    block_cursor neighbor(int face) const
+    {
+        block_cursor c = *this;
+        c.step(face);
+        return c;
+    }
+
+    /* the block under the cursor, for reading only (see peek_block);
+     * null if there is no chunk here */
+    const_block get() const
+    {
+        if (!ch) {
+            return {};
+        }
+
+        return ch->peek_block(local.x, local.y, local.z);
+    }
+
+    /* the topo node under the cursor; the outside node if there is no chunk */
+    topo_info * topo() const
+    {
+        if (!ch) {
+            return &ship->outside_topo_info;
+        }
+
+        return ch->get_topo(local.x, local.y, local.z);
+    }
+};
@@ -5,9 +5,16 @@
 #include "mesh.h"
 #include "component/c_entity.h"
 
+#include <assert.h>
 #include <vector>
 
+/* the edge length of a chunk, in blocks. chunks are templated on their
+ * size so that tools can work with other sizes, but the game itself is
+ * built around this one; override it at build time to try another.
+ */
+#ifndef CHUNK_SIZE
 #define CHUNK_SIZE 4
+#endif
 
 class btTriangleMesh;
 class btCollisionShape;
@@ -28,25 +35,233 @@ struct phys_chunk {
 struct topo_info {
     topo_info *p;
     int rank;
-    int size;   /* if p==this, then the number of blocks in this cc */
+    int size;   /* blocks: in a root, in the whole cc; in a chunk's cell or
+                 * uniform node, in that cell or chunk */
 };
 
-struct chunk {
-    fixed_cube<block, CHUNK_SIZE> blocks;
-    fixed_cube<topo_info, CHUNK_SIZE> topo;
+/* what peek_block() refers to for the blocks of a uniform chunk: one
+ * block of every type, with no surfaces or wires. this is const, and so
+ * ends up in read-only memory -- only ever read through it.
+ */
+struct uniform_block_data {
+    block_type types[256];
+    surface_type surfs[face_count];
+    unsigned char wire_mask;
+    unsigned char wire_bits[face_count];
+
+    constexpr uniform_block_data()
+        : types(), surfs(), wire_mask(), wire_bits()
+    {
+        for (int i = 0; i < 256; i++) {
+            types[i] = (block_type)i;
+        }
+    }
+};
+
+static const uniform_block_data uniform_blocks;
+
+template<int N> struct basic_chunk;
+
+/* the per-block data of a chunk which isn't uniform */
+template<int N>
+struct basic_chunk_blocks {
+    basic_chunk<N> *owner;
+
+    /* block data, one plane per attribute so that passes which only care
+     * about one of them (topology only reads surfaces, for example) walk
+     * densely packed memory. get_block() ties them back together.
+     */
+    fixed_cube<block_type, N> types;
+    fixed_cube<surface_type[face_count], N> surfs;
+    fixed_cube<unsigned char, N> wire_masks;
+    fixed_cube<unsigned char[face_count], N> wire_bits;
+
+    /* atmo topology is kept in two levels. within the chunk, blocks which
+     * air can pass between without leaving it form a cell; cells[] holds
+     * the index (in [x][y][z] order) of the cell's head, its first block.
+     * each cell is one node in the ship-wide topology: the topo node of its
+     * head. the nodes of the other blocks are unused.
+     */
+    fixed_cube<unsigned short, N> cells;
+    fixed_cube<topo_info, N> topo;
+
+    static_assert(N * N * N < 0xffff, "cell heads must fit in cells[]");
+
+    topo_info *cell_topo(unsigned head) {
+        return &topo.contents[0][0][0] + head;
+    }
+
+    /* label the cells from the surfaces, giving each head's node the size
+     * of its cell. nothing else about the nodes is touched. */
+    void find_cells() {
+        unsigned short *cell = &cells.contents[0][0][0];
+        unsigned short const unlabelled = 0xffff;
+        int const stride[] = { N * N, N, 1 };
+        std::vector<unsigned short> stack;
+
+        for (int i = 0; i < N * N * N; i++) {
+            cell[i] = unlabelled;
+        }
+
+        for (int head = 0; head < N * N * N; head++) {
+            if (cell[head] != unlabelled) {
+                continue;
+            }
+
+            int size = 0;
+            cell[head] = (unsigned short)head;
+            stack.push_back((unsigned short)head);
+
+            while (!stack.empty()) {
+                int i = stack.back();
+                stack.pop_back();
+                size++;
+
+                int c[] = { i / (N * N), i / N % N, i % N };
+                surface_type *s = surfs.contents[c[0]][c[1]][c[2]];
+                for (int f = 0; f < int(face_count); f++) {
+                    int axis = f >> 1;
+                    int step = (f & 1) ? -1 : 1;
+                    if (!air_permeable(s[f]) || c[axis] + step < 0 || c[axis] + step >= N) {
+                        continue;
+                    }
+
+                    int j = i + step * stride[axis];
+                    if (cell[j] == unlabelled) {
+                        cell[j] = (unsigned short)head;
+                        stack.push_back((unsigned short)j);
+                    }
+                }
+            }
+
+            cell_topo(head)->size = size;
+        }
+    }
+};
+
+template<int N>
+struct basic_chunk {
+    enum { size = N };
+
+    /* most chunks are nothing but untouched or empty space. those are kept
+     * uniform: a single block type for the whole chunk, no surfaces or
+     * wires, and a single topo node standing in for every block. the
+     * per-block data is only allocated when something is written, see
+     * expand().
+     */
+    basic_chunk_blocks<N> *blocks = nullptr;    /* null while uniform */
+    block_type uniform_type = block_untouched;
+    topo_info uniform_topo;
+
+    /* chunk coordinates within the ship */
+    glm::ivec3 pos;
 
     /* rendering information */
     struct render_chunk render_chunk;
     struct phys_chunk phys_chunk;
 
-    void prepare_render();
-    void prepare_phys(int x, int y, int z);
+    /* bumped whenever the chunk is dirtied, so a remesh which was started
+     * before the latest edit can tell it is stale; see chunk_mesh_queue */
+    unsigned mesh_gen = 0;
+    unsigned queued_gen = ~0u;      /* mesh_gen when last submitted */
+
+    bool is_uniform() const {
+        return !blocks;
+    }
+
+    /* the block at x, y, z, for writing. the chunk must have been expanded */
+    block get_block(int x, int y, int z) {
+        assert(blocks);
+        return block(blocks->types.get(x, y, z), *blocks->surfs.get(x, y, z),
+                     blocks->wire_masks.get(x, y, z), *blocks->wire_bits.get(x, y, z));
+    }
+
+    /* the block at x, y, z, for reading only. in a uniform chunk this is
+     * shared, read-only storage. */
+    const_block peek_block(int x, int y, int z) const {
+        if (blocks) {
+            return const_block(blocks->types.get(x, y, z), *blocks->surfs.get(x, y, z),
+                               blocks->wire_masks.get(x, y, z), *blocks->wire_bits.get(x, y, z));
+        }
+
+        return const_block(&uniform_blocks.types[uniform_type], uniform_blocks.surfs,
+                           &uniform_blocks.wire_mask, uniform_blocks.wire_bits);
+    }
+
+    /* the topo node of the block's cell */
+    topo_info *get_topo(int x, int y, int z) {
+        if (blocks) {
+            return blocks->cell_topo(*blocks->cells.get(x, y, z));
+        }
+
+        return &uniform_topo;
+    }
+
+    /* give a uniform chunk its own per-block data in mem, which must be
+     * zeroed. every block takes the uniform type; with no surfaces yet the
+     * whole chunk is one cell, headed by block 0, and that is hung off the
+     * uniform node so the topology doesn't change.
+     */
+    void expand(basic_chunk_blocks<N> *mem) {
+        assert(!blocks);
+        blocks = mem;
+        blocks->owner = this;
+
+        for (int k = 0; k < N; k++) {
+            for (int j = 0; j < N; j++) {
+                for (int i = 0; i < N; i++) {
+                    *blocks->types.get(i, j, k) = uniform_type;
+                }
+            }
+        }
+
+        topo_info *t = blocks->cell_topo(0);
+        t->p = &uniform_topo;
+        t->rank = 0;
+        t->size = N * N * N;
+    }
 
     void dirty() {
         render_chunk.valid = false;
         phys_chunk.valid = false;
+        mesh_gen++;
     }
 };
 
+typedef basic_chunk<CHUNK_SIZE> chunk;
+typedef basic_chunk_blocks<CHUNK_SIZE> chunk_blocks;
+
+/* split a single block coordinate into the chunk containing it, and the
+ * offset of the block within that chunk. either output may be null.
+ */
+template<int N = CHUNK_SIZE>
+static inline void
+split_coord(int p, int *out_block, int *out_chunk)
+{
+    /* NOTE: There are a number of attractive-looking symmetries which are
+     * just plain wrong. */
+    int block, chunk;
+
+    if (p < 0) {
+        /* negative space is not a mirror of positive:
+         * chunk -1 spans blocks -8..-1;
+         * chunk -2 spans blocks -16..-9 */
+        chunk = (p - N + 1) / N;
+    } else {
+        /* positive halfspace has no rocket science. */
+        chunk = p / N;
+    }
+
+    /* the within-chunk offset is just the difference between the minimum block
+     * in the chunk and the requested one, regardless of which halfspace we're in. */
+    block = p - N * chunk;
+
+    /* write the outputs which were requested */
+    if (out_block)
+        *out_block = block;
+    if (out_chunk)
+        *out_chunk = chunk;
+}
+
 /* must be called once before the mesher can be used */
 void mesher_init();
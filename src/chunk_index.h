@@ -0,0 +1,222 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <utility>
+#include <vector>
+
+#include "chunk.h"
+
+#define CHUNK_INDEX_PAGE_SIZE 8
+
+/* sparse mapping from chunk coordinates to chunks
+ *
+ * this is a two-level paged grid:
+ *  - a dense directory covering the bounding box (in pages) of every
+ *    chunk we've seen, holding a pointer to each page or null
+ *  - fixed-size pages of CHUNK_INDEX_PAGE_SIZE^3 chunk pointers
+ *
+ * a lookup is two array indexings with no hashing, and chunks which are
+ * neighbours in space are (mostly) neighbours in memory. missing pages and
+ * missing chunks both give nullptr, so the sparse semantics of the old
+ * hash map are kept.
+ *
+ * for iteration over every chunk, a dense list of (coord, chunk) entries is
+ * kept alongside, in insertion order.
+ */
+struct chunk_index {
+    typedef std::pair<glm::ivec3, chunk *> entry;
+
+    chunk_index() = default;
+    chunk_index(chunk_index const &) = delete;
+    chunk_index & operator=(chunk_index const &) = delete;
+
+    ~chunk_index()
+    {
+        for (auto p : directory) {
+            delete p;
+        }
+    }
+
+    /* returns the chunk at chunk coordinates v, or null */
+    chunk * get(glm::ivec3 v) const
+    {
+        glm::ivec3 pg, local;
+        split(v, &pg, &local);
+
+        page const *p = get_page(pg);
+        if (!p) {
+            return nullptr;
+        }
+
+        return p->slots[local.z][local.y][local.x];
+    }
+
+    /* associate chunk ch with chunk coordinates v.
+     * any existing chunk at v is replaced, but NOT freed.
+     */
+    void set(glm::ivec3 v, chunk *ch)
+    {
+        glm::ivec3 pg, local;
+        split(v, &pg, &local);
+
+        if (!ch) {
+            erase(v);
+            return;
+        }
+
+        page *p = ensure_page(pg);
+        chunk *&slot = p->slots[local.z][local.y][local.x];
+
+        if (slot) {
+            for (auto &e : entries) {
+                if (e.first == v) {
+                    e.second = ch;
+                    break;
+                }
+            }
+        }
+        else {
+            entries.push_back(entry(v, ch));
+        }
+
+        slot = ch;
+    }
+
+    /* forget the chunk at v, if any. the chunk itself is NOT freed. */
+    void erase(glm::ivec3 v)
+    {
+        glm::ivec3 pg, local;
+        split(v, &pg, &local);
+
+        page *p = get_page(pg);
+        if (!p || !p->slots[local.z][local.y][local.x]) {
+            return;
+        }
+
+        p->slots[local.z][local.y][local.x] = nullptr;
+
+        for (auto it = entries.begin(); it != entries.end(); it++) {
+            if (it->first == v) {
+                *it = entries.back();
+                entries.pop_back();
+                break;
+            }
+        }
+    }
+
+    size_t size() const
+    {
+        return entries.size();
+    }
+
+    /* iteration over every chunk present, as (coord, chunk) pairs */
+    std::vector<entry>::const_iterator begin() const { return entries.begin(); }
+    std::vector<entry>::const_iterator end() const { return entries.end(); }
+
+private:
+    struct page {
+        chunk *slots[CHUNK_INDEX_PAGE_SIZE][CHUNK_INDEX_PAGE_SIZE][CHUNK_INDEX_PAGE_SIZE];
+    };
+
+    /* the directory covers pages page_mins..page_maxs inclusive;
+     * it is empty until the first chunk is set.
+     */
+    glm::ivec3 page_mins{0};
+    glm::ivec3 page_maxs{-1};
+    std::vector<page *> directory;
+
+    std::vector<entry> entries;
+
+    static int
+    floor_div(int p)
+    {
+        /* negative space is not a mirror of positive, see split_coord */
+        return p < 0 ? (p - CHUNK_INDEX_PAGE_SIZE + 1) / CHUNK_INDEX_PAGE_SIZE
+                     : p / CHUNK_INDEX_PAGE_SIZE;
+    }
+
+    static void
+    split(glm::ivec3 v, glm::ivec3 *pg, glm::ivec3 *local)
+    {
+        pg->x = floor_div(v.x);
+        pg->y = floor_div(v.y);
+        pg->z = floor_div(v.z);
+        *local = v - CHUNK_INDEX_PAGE_SIZE * *pg;
+    }
+
+    bool
+    covers(glm::ivec3 pg) const
+    {
+        return pg.x >= page_mins.x && pg.x <= page_maxs.x &&
+               pg.y >= page_mins.y && pg.y <= page_maxs.y &&
+               pg.z >= page_mins.z && pg.z <= page_maxs.z;
+    }
+
+    size_t
+    directory_index(glm::ivec3 pg) const
+    {
+        glm::ivec3 dims = page_maxs - page_mins + 1;
+        glm::ivec3 d = pg - page_mins;
+        return (size_t)d.x + (size_t)dims.x * ((size_t)d.y + (size_t)dims.y * (size_t)d.z);
+    }
+
+    page *
+    get_page(glm::ivec3 pg) const
+    {
+        if (!covers(pg)) {
+            return nullptr;
+        }
+
+        return directory[directory_index(pg)];
+    }
+
+    page *
+    ensure_page(glm::ivec3 pg)
+    {
+        if (!covers(pg)) {
+            grow(pg);
+        }
+
+        page *&p = directory[directory_index(pg)];
+        if (!p) {
+            p = new page{};
+        }
+
+        return p;
+    }
+
+    /* extend the directory to cover pg. this is rare -- only when the ship
+     * grows past its current extents by a whole page -- so we just lay out
+     * a fresh directory and move the page pointers across.
+     */
+    void
+    grow(glm::ivec3 pg)
+    {
+        glm::ivec3 old_mins = page_mins;
+        glm::ivec3 old_maxs = page_maxs;
+        std::vector<page *> old_directory(std::move(directory));
+
+        if (old_directory.empty()) {
+            page_mins = pg;
+            page_maxs = pg;
+        }
+        else {
+            page_mins = glm::min(page_mins, pg);
+            page_maxs = glm::max(page_maxs, pg);
+        }
+
+        glm::ivec3 dims = page_maxs - page_mins + 1;
+        directory.assign((size_t)dims.x * dims.y * dims.z, nullptr);
+
+        for (int k = old_mins.z; k <= old_maxs.z; k++) {
+            for (int j = old_mins.y; j <= old_maxs.y; j++) {
+                for (int i = old_mins.x; i <= old_maxs.x; i++) {
+                    glm::ivec3 od = glm::ivec3(i, j, k) - old_mins;
+                    glm::ivec3 odims = old_maxs - old_mins + 1;
+                    page *p = old_directory[od.x + odims.x * (od.y + odims.y * od.z)];
+                    directory[directory_index(glm::ivec3(i, j, k))] = p;
+                }
+            }
+        }
+    }
+};
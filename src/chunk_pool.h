@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "chunk.h"
+
+/* default number of objects carved out of each slab */
+#define CHUNK_POOL_SLAB_SIZE 64
+
+/* slab allocator for chunks, and for their per-block data
+ *
+ * objects are carved in order out of large contiguous slabs, so chunks
+ * created together (an enclosed region, a loaded ship) sit together in
+ * memory, in the same order the chunk index iterates them. freed objects
+ * go onto a free list and are handed out again before any fresh slab
+ * space.
+ *
+ * alloc() gives a zeroed T, the same as new T() did. all slabs are
+ * released when the pool is destroyed, and any object still in them is
+ * destroyed first, so the pool must outlive every object it handed out.
+ *
+ * owner_of() maps a pointer anywhere inside a T back to that T, by a
+ * binary search over the slabs.
+ */
+template<typename T>
+struct slab_pool {
+    slab_pool() = default;
+    slab_pool(slab_pool const &) = delete;
+    slab_pool & operator=(slab_pool const &) = delete;
+
+    ~slab_pool()
+    {
+        /* every slot which isn't free holds a live object */
+        std::vector<void *> unused(free_list);
+        for (size_t i = 0; i < slab_remaining; i++) {
+            unused.push_back(slab_next + i);
+        }
+        std::sort(unused.begin(), unused.end(), std::less<void *>());
+
+        for (auto &s : slabs) {
+            for (size_t i = 0; i < s.n; i++) {
+                void *p = s.begin + i;
+                if (!std::binary_search(unused.begin(), unused.end(), p, std::less<void *>())) {
+                    reinterpret_cast<T *>(p)->~T();
+                }
+            }
+
+            delete [] s.begin;
+        }
+    }
+
+    T * alloc()
+    {
+        void *p;
+
+        if (!free_list.empty()) {
+            p = free_list.back();
+            free_list.pop_back();
+        }
+        else {
+            if (!slab_remaining) {
+                new_slab(CHUNK_POOL_SLAB_SIZE);
+            }
+
+            p = slab_next++;
+            slab_remaining--;
+        }
+
+        return new (p) T();
+    }
+
+    void free(T *t)
+    {
+        t->~T();
+        free_list.push_back(t);
+    }
+
+    /* make sure the next n allocations are satisfied without touching the
+     * system allocator again, with any fresh ones in a single slab. */
+    void reserve(size_t n)
+    {
+        size_t available = free_list.size() + slab_remaining;
+        if (n > available) {
+            new_slab(n - available);
+        }
+    }
+
+    /* the object which p points into, or null if p isn't in this pool */
+    T * owner_of(void const *p) const
+    {
+        std::less<void const *> before;
+
+        /* the first slab starting beyond p; p can only be in the one
+         * before it */
+        auto it = std::upper_bound(slabs.begin(), slabs.end(), p,
+            [&](void const *q, slab const &s) { return before(q, s.begin); });
+        if (it == slabs.begin()) {
+            return nullptr;
+        }
+
+        --it;
+        if (!before(p, it->begin + it->n)) {
+            return nullptr;
+        }
+
+        auto offset = (char const *)p - (char const *)it->begin;
+        return reinterpret_cast<T *>(it->begin + offset / sizeof(slot));
+    }
+
+private:
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type slot;
+
+    struct slab {
+        slot *begin;
+        size_t n;
+    };
+
+    /* in address order, for owner_of() */
+    std::vector<slab> slabs;
+    std::vector<void *> free_list;
+
+    slot *slab_next = nullptr;
+    size_t slab_remaining = 0;
+
+    void new_slab(size_t n)
+    {
+        /* anything left in the current slab is not lost, just recycled */
+        while (slab_remaining) {
+            free_list.push_back(slab_next++);
+            slab_remaining--;
+        }
+
+        slot *s = new slot[n];
+        std::less<void const *> before;
+        auto it = std::upper_bound(slabs.begin(), slabs.end(), s,
+            [&](slot const *q, slab const &t) { return before(q, t.begin); });
+        slabs.insert(it, slab{s, n});
+        slab_next = s;
+        slab_remaining = n;
+    }
+};
+
+typedef slab_pool<chunk> chunk_pool;
+typedef slab_pool<chunk_blocks> chunk_blocks_pool;
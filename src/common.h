@@ -4,6 +4,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "block.h"
 #include "timer.h"
 #include "component/c_entity.h"
 
@@ -77,7 +78,7 @@ struct raycast_info_block {
     glm::ivec3 bl;          /* the block we hit */
     glm::ivec3 n;           /* the face normal we hit */
     glm::ivec3 p;           /* the block along the normal */
-    struct block *block;
+    const_block block;      /* handle to the block at bl, for reading */
     float t;                /* distance along the ray */
     glm::vec3 hitCoord;     /* intersection point in ship space */
 };
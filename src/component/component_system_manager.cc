@@ -75,14 +75,19 @@ tick_gas_producers(ship_space *ship)
         auto mat = glm::mat3(*position.mat);
         auto pos = glm::vec3((*position.mat)[3]);
 
-        /* topo node containing the entity */
-        topo_info *t = topo_find(ship->get_topo_info(get_coord_containing(pos)));
-        zone_info *z = ship->get_zone_info(t);
-        if (!z) {
+        /* zone containing the entity */
+        auto zone = ship->cached_zone(get_coord_containing(pos), &gas_man.instance_pool.zone_block[i],
+                                      &gas_man.instance_pool.zone_epoch[i], &gas_man.instance_pool.zone[i]);
+        if (!zone) {
             /* if there wasn't a zone, make one */
-            z = ship->zones[t] = new zone_info{};
+            ship->ensure_zone(topo_find(ship->get_topo_info(gas_man.instance_pool.zone_block[i])));
+            zone = ship->cached_zone(get_coord_containing(pos), &gas_man.instance_pool.zone_block[i],
+                                     &gas_man.instance_pool.zone_epoch[i], &gas_man.instance_pool.zone[i]);
         }
 
+        topo_info *t = ship->zone_root[zone];
+        zone_info *z = &ship->zone_data[zone];
+
         /* add some gas if we can, up to our pressure limit */
         float max_gas = gas_man.instance_pool.max_pressure[i] * t->size;
 
@@ -293,6 +298,40 @@ tick_door_slider_components(ship_space *ship) {
     }
 }
 
+void
+tick_door_openings(ship_space *ship) {
+    auto &slider_man = component_system_man.managers.door_slider_component_man;
+    auto &par_man = component_system_man.managers.parent_component_man;
+    auto &surf_man = component_system_man.managers.surface_attachment_component_man;
+
+    /* each leaf of a door uncovers as much of the doorway as it has slid
+     * aside; air gets through the door surfaces of the block the door
+     * stands in. */
+    ship->openings.clear();
+
+    for (auto i = 0u; i < slider_man.buffer.num; i++) {
+        auto ce = slider_man.instance_pool.entity[i];
+        auto par = par_man.get_instance_data(ce);
+
+        if (!surf_man.exists(*par.parent)) {
+            continue;
+        }
+
+        auto sa = surf_man.get_instance_data(*par.parent);
+        if (!*sa.attached) {
+            continue;
+        }
+
+        auto width = slider_man.instance_pool.position[i] * glm::length(slider_man.instance_pool.open_position[i]);
+        auto bl = ship->peek_block(*sa.block);
+        for (auto face = 0; bl && face < int(face_count); face++) {
+            if (bl.surfs[face] == surface_door) {
+                ship->add_opening(*sa.block, face, width);
+            }
+        }
+    }
+}
+
 
 void
 tick_pressure_sensors(ship_space* ship) {
@@ -307,11 +346,10 @@ tick_pressure_sensors(ship_space* ship) {
         auto pos = glm::vec3((*pos_man.get_instance_data(ce).mat)[3]);
         auto network = *cwire_man.get_instance_data(ce).network;
 
-        glm::ivec3 pos_block = get_coord_containing(pos);
-
-        topo_info *t = topo_find(ship->get_topo_info(pos_block));
-        zone_info *z = ship->get_zone_info(t);
-        float pressure = z ? (z->gas_amount[int(gas::oxygen)] / t->size) : 0.0f;
+        auto zone = ship->cached_zone(get_coord_containing(pos), &pressure_man.instance_pool.zone_block[i],
+                                      &pressure_man.instance_pool.zone_epoch[i], &pressure_man.instance_pool.zone[i]);
+        float pressure = zone ? (ship->zone_data[zone].gas_amount[int(gas::oxygen)] / ship->zone_root[zone]->size) : 0.0f;
+        pressure = std::max(0.0f, pressure + ship->field.deviation(ship, pressure_man.instance_pool.zone_block[i]));
 
         comms_msg msg{
             ce,
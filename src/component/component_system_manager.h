@@ -35,6 +35,9 @@ tick_rotator_components(ship_space *ship, float dt);
 void
 tick_door_slider_components(ship_space *ship);
 
+void
+tick_door_openings(ship_space *ship);
+
 void
 tick_pressure_sensors(ship_space *ship);
 
@@ -24,6 +24,9 @@ gas_producer_component_manager::create_component_instance_data(unsigned count) {
     size = sizeof(float) * count + align_size<float>(size);
     size = sizeof(float) * count + align_size<float>(size);
     size = sizeof(bool) * count + align_size<bool>(size);
+    size = sizeof(glm::ivec3) * count + align_size<glm::ivec3>(size);
+    size = sizeof(unsigned) * count + align_size<unsigned>(size);
+    size = sizeof(unsigned) * count + align_size<unsigned>(size);
     size += 16;   // for worst-case misalignment of initial ptr
 
     new_buffer.buffer = malloc(size);
@@ -37,6 +40,9 @@ gas_producer_component_manager::create_component_instance_data(unsigned count) {
     new_pool.flow_rate = align_ptr((float *)(new_pool.gas_type + count));
     new_pool.max_pressure = align_ptr((float *)(new_pool.flow_rate + count));
     new_pool.enabled = align_ptr((bool *)(new_pool.max_pressure + count));
+    new_pool.zone_block = align_ptr((glm::ivec3 *)(new_pool.enabled + count));
+    new_pool.zone_epoch = align_ptr((unsigned *)(new_pool.zone_block + count));
+    new_pool.zone = align_ptr((unsigned *)(new_pool.zone_epoch + count));
 
     memcpy(new_pool.entity, instance_pool.entity, buffer.num * sizeof(c_entity));
     memcpy(new_pool.filter, instance_pool.filter, buffer.num * sizeof(wire_filter_ptr));
@@ -44,6 +50,9 @@ gas_producer_component_manager::create_component_instance_data(unsigned count) {
     memcpy(new_pool.flow_rate, instance_pool.flow_rate, buffer.num * sizeof(float));
     memcpy(new_pool.max_pressure, instance_pool.max_pressure, buffer.num * sizeof(float));
     memcpy(new_pool.enabled, instance_pool.enabled, buffer.num * sizeof(bool));
+    memcpy(new_pool.zone_block, instance_pool.zone_block, buffer.num * sizeof(glm::ivec3));
+    memcpy(new_pool.zone_epoch, instance_pool.zone_epoch, buffer.num * sizeof(unsigned));
+    memcpy(new_pool.zone, instance_pool.zone, buffer.num * sizeof(unsigned));
 
     free(buffer.buffer);
     buffer = new_buffer;
@@ -63,6 +72,9 @@ gas_producer_component_manager::destroy_instance(instance i) {
     instance_pool.flow_rate[i.index] = instance_pool.flow_rate[last_index];
     instance_pool.max_pressure[i.index] = instance_pool.max_pressure[last_index];
     instance_pool.enabled[i.index] = instance_pool.enabled[last_index];
+    instance_pool.zone_block[i.index] = instance_pool.zone_block[last_index];
+    instance_pool.zone_epoch[i.index] = instance_pool.zone_epoch[last_index];
+    instance_pool.zone[i.index] = instance_pool.zone[last_index];
 
     entity_instance_map[last_entity] = i.index;
     entity_instance_map.erase(current_entity);
@@ -95,6 +107,9 @@ gas_producer_component_stub::assign_component_to_entity(c_entity entity) {
     *data.flow_rate = flow_rate;
     *data.max_pressure = max_pressure;
     *data.enabled = true;
+    *data.zone_block = glm::ivec3(0);
+    *data.zone_epoch = 0;
+    *data.zone = 0;
 };
 
 std::unique_ptr<component_stub> gas_producer_component_stub::from_config(const config_setting_t *config) {
@@ -17,6 +17,9 @@ struct gas_producer_component_manager : component_manager<gas_producer_component
         float *flow_rate;
         float *max_pressure;
         bool *enabled;
+        glm::ivec3 *zone_block;
+        unsigned *zone_epoch;
+        unsigned *zone;
     } instance_pool;
 
     void create_component_instance_data(unsigned count) override;
@@ -37,6 +40,9 @@ struct gas_producer_component_manager : component_manager<gas_producer_component
         d.flow_rate = instance_pool.flow_rate + inst.index;
         d.max_pressure = instance_pool.max_pressure + inst.index;
         d.enabled = instance_pool.enabled + inst.index;
+        d.zone_block = instance_pool.zone_block + inst.index;
+        d.zone_epoch = instance_pool.zone_epoch + inst.index;
+        d.zone = instance_pool.zone + inst.index;
 
         return d;
     }
@@ -20,6 +20,9 @@ pressure_sensor_component_manager::create_component_instance_data(unsigned count
 
     size_t size = sizeof(c_entity) * count;
     size = sizeof(float) * count + align_size<float>(size);
+    size = sizeof(glm::ivec3) * count + align_size<glm::ivec3>(size);
+    size = sizeof(unsigned) * count + align_size<unsigned>(size);
+    size = sizeof(unsigned) * count + align_size<unsigned>(size);
     size += 16;   // for worst-case misalignment of initial ptr
 
     new_buffer.buffer = malloc(size);
@@ -29,9 +32,15 @@ pressure_sensor_component_manager::create_component_instance_data(unsigned count
 
     new_pool.entity = align_ptr((c_entity *)new_buffer.buffer);
     new_pool.pressure = align_ptr((float *)(new_pool.entity + count));
+    new_pool.zone_block = align_ptr((glm::ivec3 *)(new_pool.pressure + count));
+    new_pool.zone_epoch = align_ptr((unsigned *)(new_pool.zone_block + count));
+    new_pool.zone = align_ptr((unsigned *)(new_pool.zone_epoch + count));
 
     memcpy(new_pool.entity, instance_pool.entity, buffer.num * sizeof(c_entity));
     memcpy(new_pool.pressure, instance_pool.pressure, buffer.num * sizeof(float));
+    memcpy(new_pool.zone_block, instance_pool.zone_block, buffer.num * sizeof(glm::ivec3));
+    memcpy(new_pool.zone_epoch, instance_pool.zone_epoch, buffer.num * sizeof(unsigned));
+    memcpy(new_pool.zone, instance_pool.zone, buffer.num * sizeof(unsigned));
 
     free(buffer.buffer);
     buffer = new_buffer;
@@ -47,6 +56,9 @@ pressure_sensor_component_manager::destroy_instance(instance i) {
 
     instance_pool.entity[i.index] = instance_pool.entity[last_index];
     instance_pool.pressure[i.index] = instance_pool.pressure[last_index];
+    instance_pool.zone_block[i.index] = instance_pool.zone_block[last_index];
+    instance_pool.zone_epoch[i.index] = instance_pool.zone_epoch[last_index];
+    instance_pool.zone[i.index] = instance_pool.zone[last_index];
 
     entity_instance_map[last_entity] = i.index;
     entity_instance_map.erase(current_entity);
@@ -75,6 +87,9 @@ pressure_sensor_component_stub::assign_component_to_entity(c_entity entity) {
     auto data = man.get_instance_data(entity);
 
     *data.pressure = 0;
+    *data.zone_block = glm::ivec3(0);
+    *data.zone_epoch = 0;
+    *data.zone = 0;
 };
 
 std::unique_ptr<component_stub> pressure_sensor_component_stub::from_config(const config_setting_t *config) {
@@ -13,6 +13,9 @@ struct pressure_sensor_component_manager : component_manager<pressure_sensor_com
     struct instance_data {
         c_entity *entity;
         float *pressure;
+        glm::ivec3 *zone_block;
+        unsigned *zone_epoch;
+        unsigned *zone;
     } instance_pool;
 
     void create_component_instance_data(unsigned count) override;
@@ -29,6 +32,9 @@ struct pressure_sensor_component_manager : component_manager<pressure_sensor_com
 
         d.entity = instance_pool.entity + inst.index;
         d.pressure = instance_pool.pressure + inst.index;
+        d.zone_block = instance_pool.zone_block + inst.index;
+        d.zone_epoch = instance_pool.zone_epoch + inst.index;
+        d.zone = instance_pool.zone + inst.index;
 
         return d;
     }
@@ -25,6 +25,36 @@ extern player pl;
 std::vector<std::string> entity_names{};
 std::unordered_map<std::string, entity_data> entity_stubs{};
 
+/* forget where ce was attached; must be called while its surface
+ * attachment still says where that was */
+static void
+unindex_attachment(c_entity ce)
+{
+    auto &surface_man = component_system_man.managers.surface_attachment_component_man;
+    if (!surface_man.exists(ce)) {
+        return;
+    }
+
+    auto surface = surface_man.get_instance_data(ce);
+    if (*surface.attached) {
+        ship->remove_attachment(ce, *surface.block);
+    }
+}
+
+void
+index_attached_entities(ship_space *into)
+{
+    auto &surface_man = component_system_man.managers.surface_attachment_component_man;
+    into->attachments.clear();
+
+    for (auto i = 0u; i < surface_man.buffer.num; i++) {
+        if (surface_man.instance_pool.attached[i]) {
+            into->add_attachment(surface_man.instance_pool.entity[i], surface_man.instance_pool.block[i],
+                                 surface_man.instance_pool.face[i]);
+        }
+    }
+}
+
 bool
 load_entity(entity_data& entity, config_setting_t *e) {
     // required to be a valid entity
@@ -224,6 +254,9 @@ void
 attach_entity_to_surface(c_entity ce, glm::ivec3 p, int face) {
     auto &surface_man = component_system_man.managers.surface_attachment_component_man;
     if (surface_man.exists(ce)) {
+        unindex_attachment(ce);
+        ship->add_attachment(ce, p, face);
+
         auto surface = surface_man.get_instance_data(ce);
         *surface.block = p;
         *surface.face = face;
@@ -290,6 +323,7 @@ destroy_entity(c_entity e) {
         teardown_physics_setup(nullptr, nullptr, phys_data.rigid);
     }
 
+    unindex_attachment(e);
     component_system_man.managers.destroy_entity_instance(e);
 
     auto &parent_man = component_system_man.managers.parent_component_man;
@@ -325,6 +359,7 @@ void pop_entity_off(c_entity entity) {
         auto &sam = component_system_man.managers.surface_attachment_component_man;
         auto ph = phys.get_instance_data(entity);
         auto sa = sam.get_instance_data(entity);
+        unindex_attachment(entity);
         *sa.attached = false;
         convert_static_rb_to_dynamic(*ph.rigid, *ph.mass);
     }
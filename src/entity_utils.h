@@ -2,6 +2,7 @@
 
 #include <glm/glm.hpp>
 #include <string>
+#include <vector>
 
 #include "component/c_entity.h"
 #include "common.h"
@@ -19,6 +20,12 @@ spawn_floating_generic_entity(glm::mat4 mat, const char *mesh, const char *phys_
 void
 attach_entity_to_surface(c_entity ce, glm::ivec3 p, int face);
 
+/* file every entity which is attached to a surface in ship's index of
+ * them, in place of whatever it held. the entities outlive any one ship,
+ * so one swapped in needs them all; see replace_ship */
+void
+index_attached_entities(ship_space *ship);
+
 void
 destroy_entity(c_entity e);
 
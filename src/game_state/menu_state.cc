@@ -13,12 +13,13 @@ extern action const* get_input(en_action a);
 extern void set_next_game_state(game_state *s);
 extern void apply_video_settings();
 extern void request_exit();
-extern void teardown_chunks();
+extern void replace_ship(ship_space *new_ship);
 
 extern en_settings game_settings;
 extern ship_space *ship;
 extern SoLoud::Soloud * audio;
 extern bool draw_fps, draw_debug_text, draw_debug_chunks, draw_debug_axis, draw_debug_physics;
+extern bool pressure_field_mode;
 
 extern glm::vec3 fp_item_offset;
 extern float fp_item_scale;
@@ -104,10 +105,9 @@ struct menu_state : game_state {
             if (ImGui::Button("Load")) {
                 // we may want to get clever and pause the world or defer this to
                 // a particular time
-                teardown_chunks();
-                delete ship;
-                ship = new ship_space();
-                load(ship, "save/ship.out");
+                auto new_ship = new ship_space();
+                load(new_ship, "save/ship.out");
+                replace_ship(new_ship);
 
                 set_next_game_state(create_play_state());
             }
@@ -155,6 +155,7 @@ struct menu_state : game_state {
             ImGui::Checkbox("Draw Chunk Debug", &draw_debug_chunks);
             ImGui::Checkbox("Draw Axis Debug", &draw_debug_axis);
             ImGui::Checkbox("Draw Physics Debug", &draw_debug_physics);
+            ImGui::Checkbox("Per-Block Pressure", &pressure_field_mode);
 
             ImGui::Separator();
             ImGui::SliderFloat3("FP item offset", glm::value_ptr(fp_item_offset), -0.5f, 0.5f);
@@ -113,8 +113,7 @@ struct play_state : game_state {
 
             topo_info *t = topo_find(ship->get_topo_info(eye_block));
             topo_info *outside = topo_find(&ship->outside_topo_info);
-            zone_info *z = ship->get_zone_info(t);
-            float pressure = z ? (z->gas_amount[int(gas::oxygen)] / t->size) : 0.0f;
+            float pressure = ship->pressure_at(eye_block);
 
             if (t != outside) {
                 sprintf(buf2, "[INSIDE %p %d %.1f atmo %.2f]", t, t->size, pressure, pl.thing);
@@ -128,11 +127,13 @@ struct play_state : game_state {
             add_text_with_outline(buf2, -w/2, -100);
 
             w = 0; h = 0;
-            sprintf(buf2, "full: %d fast-unify: %d fast-nosplit: %d false-split: %d",
+            sprintf(buf2, "full: %d fast-unify: %d fast-nosplit: %d false-split: %d fast-split: %d split-visits: %d",
                     ship->num_full_rebuilds,
                     ship->num_fast_unifys,
                     ship->num_fast_nosplits,
-                    ship->num_false_splits);
+                    ship->num_false_splits,
+                    ship->num_fast_splits,
+                    ship->num_split_visits);
             text->measure(buf2, &w, &h);
             add_text_with_outline(buf2, -w/2, -150);
         }
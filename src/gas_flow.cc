@@ -0,0 +1,93 @@
+#include <algorithm>
+
+#include "gas_flow.h"
+
+void
+gas_flow::clear()
+{
+    zone_topo.clear();
+    inv_volume.clear();
+    for (auto &a : amount) {
+        a.clear();
+    }
+
+    edge_a.clear();
+    edge_b.clear();
+    edge_k.clear();
+}
+
+unsigned
+gas_flow::add_zone(topo_info *t, float volume, float const *gas)
+{
+    zone_topo.push_back(t);
+    inv_volume.push_back(volume > 0 ? 1.0f / volume : 0.0f);
+    for (int g = 0; g < int(gas::upper_bound); g++) {
+        amount[g].push_back(gas && volume > 0 ? gas[g] : 0.0f);
+    }
+
+    return num_zones() - 1;
+}
+
+void
+gas_flow::add_edge(unsigned a, unsigned b, float k)
+{
+    edge_a.push_back(a);
+    edge_b.push_back(b);
+    edge_k.push_back(k);
+}
+
+void
+gas_flow::step(float dt)
+{
+    unsigned nz = num_zones();
+    unsigned ne = num_edges();
+
+    pressure.resize(nz);
+    moved.resize(ne);
+    rate.resize(ne);
+    degree.assign(nz, 0);
+
+    unsigned const *ea = edge_a.data();
+    unsigned const *eb = edge_b.data();
+    float const *iv = inv_volume.data();
+    float *p = pressure.data();
+    float *m = moved.data();
+    float *r = rate.data();
+
+    for (unsigned e = 0; e < ne; e++) {
+        degree[ea[e]]++;
+        degree[eb[e]]++;
+    }
+
+    /* an edge may take at most 1/(2 * degree) of either end's gas, so that
+     * all of a zone's edges together leave it at least half */
+    for (unsigned e = 0; e < ne; e++) {
+        float la = degree[ea[e]] * iv[ea[e]];
+        float lb = degree[eb[e]] * iv[eb[e]];
+        float l = std::max(la, lb);
+        r[e] = l > 0 ? std::min(edge_k[e] * dt, 0.5f / l) : 0.0f;
+    }
+
+    for (auto &column : amount) {
+        float *am = column.data();
+
+        for (unsigned i = 0; i < nz; i++) {
+            p[i] = am[i] * iv[i];
+        }
+
+        for (unsigned e = 0; e < ne; e++) {
+            m[e] = r[e] * (p[ea[e]] - p[eb[e]]);
+        }
+
+        /* edges sharing a zone would collide here, so this one is scalar */
+        for (unsigned e = 0; e < ne; e++) {
+            am[ea[e]] -= m[e];
+            am[eb[e]] += m[e];
+        }
+
+        /* whatever reached vacuum is gone */
+        for (unsigned i = 0; i < nz; i++) {
+            am[i] = iv[i] > 0 ? am[i] : 0.0f;
+        }
+    }
+}
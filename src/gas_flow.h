@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+
+#include "enums/enums.h"
+
+struct topo_info;
+
+/* gas moving between zones which the topology keeps apart, through
+ * openings which let some air by without joining them: doors part open,
+ * and holes out to vacuum.
+ *
+ * the zones taking part, and the openings between them, are numbered
+ * densely for each tick and kept as columns: one array per gas, one for
+ * the volumes, one per edge field. a step is then a few flat loops over
+ * those arrays which the compiler can vectorize, plus one pass adding up
+ * what each edge moved.
+ *
+ * an edge moves k * dt * (pa - pb) of each gas from a to b, where pa and
+ * pb are the amounts per block. k is cut down where needed so that no
+ * zone can give away more than half of what it holds in one step, however
+ * many edges it has, so the step stays stable for any dt.
+ *
+ * a zone with no volume is open vacuum: its pressure is always zero, and
+ * whatever flows into it is lost.
+ */
+struct gas_flow {
+    /* per zone */
+    std::vector<topo_info *> zone_topo;
+    std::vector<float> inv_volume;
+    std::vector<float> amount[int(gas::upper_bound)];
+
+    /* per edge */
+    std::vector<unsigned> edge_a;
+    std::vector<unsigned> edge_b;
+    std::vector<float> edge_k;
+
+    /* scratch for step() */
+    std::vector<float> pressure;
+    std::vector<float> moved;
+    std::vector<float> rate;
+    std::vector<unsigned> degree;
+
+    void clear();
+
+    /* add a zone of `volume` blocks (0 for vacuum) holding `gas`, which may
+     * be null for none; returns its index */
+    unsigned add_zone(topo_info *t, float volume, float const *gas);
+
+    /* let gas between zones a and b, at k blocks per second per unit of
+     * pressure difference */
+    void add_edge(unsigned a, unsigned b, float k);
+
+    /* move dt seconds' worth of gas along every edge */
+    void step(float dt);
+
+    unsigned num_zones() const { return (unsigned)zone_topo.size(); }
+    unsigned num_edges() const { return (unsigned)edge_a.size(); }
+};
@@ -2,6 +2,8 @@
 #include <cstdint>
 #include <iostream>
 #include <iomanip>
+#include <unordered_set>
+#include <vector>
 
 #include "ship_space.h"
 
@@ -73,14 +75,31 @@ void loader::skip(uint32_t i) {
     fseek(f, i, SEEK_CUR);
 }
 
-static uint32_t load_chunk(loader *l, ship_space *ship) {
-    auto ch = new chunk();
+/* the chunk size of files saved before INFO recorded it */
+#define LEGACY_CHUNK_SIZE 4
+
+/* a chunk as it was saved. the file may have been saved with a different
+ * chunk size than we are built with, so the planes are read as they come
+ * and each block is placed by its ship position afterwards. a uniform
+ * chunk is saved as just its type, and has no planes.
+ */
+struct saved_chunk {
+    glm::ivec3 pos;
+    unsigned n = LEGACY_CHUNK_SIZE;
+    bool uniform = false;
+    unsigned char uniform_type = block_untouched;
+    std::vector<unsigned char> types, surfs, wires;
+    std::vector<uint32_t> conns;
+};
+
+static uint32_t load_chunk(loader *l, std::vector<saved_chunk> &chunks) {
+    chunks.emplace_back();
+    auto &sc = chunks.back();
 
     uint32_t read = 0;
     auto chunk_size = l->read_length(read);
     chunk_size += read;
     uint32_t chunk_read = read;
-    glm::ivec3 chunk_pos;
 
     while (chunk_read < chunk_size) {
         auto type = l->read_type(read);
@@ -88,84 +107,149 @@ static uint32_t load_chunk(loader *l, ship_space *ship) {
         auto size = l->read_length(read);
         chunk_read += read;
         if (type == fourcc("INFO")) {
-            assert(size == sizeof(uint32_t) * 3);
+            assert(size == sizeof(uint32_t) * 3 || size == sizeof(uint32_t) * 4);
 
-            chunk_pos.x = l->read<uint32_t>(read);
+            sc.pos.x = l->read<uint32_t>(read);
             chunk_read += read;
 
-            chunk_pos.y = l->read<uint32_t>(read);
+            sc.pos.y = l->read<uint32_t>(read);
             chunk_read += read;
 
-            chunk_pos.z = l->read<uint32_t>(read);
+            sc.pos.z = l->read<uint32_t>(read);
+            chunk_read += read;
+
+            if (size == sizeof(uint32_t) * 4) {
+                sc.n = l->read<uint32_t>(read);
+                chunk_read += read;
+            }
+        } else if (type == fourcc("FILL")) {
+            assert(size == sizeof(unsigned char));
+
+            sc.uniform = true;
+            sc.uniform_type = l->read<unsigned char>(read);
             chunk_read += read;
         } else if (type == fourcc("FRAM")) {
-            assert(size == sizeof(unsigned char) * CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE);
-
-            for (auto k = 0u; k < CHUNK_SIZE; k++) {
-                for (auto j = 0u; j < CHUNK_SIZE; j++) {
-                    for (auto i = 0u; i < CHUNK_SIZE; i++) {
-                        ch->blocks.get(i, j, k);
-                        auto bl = ch->blocks.get(i, j, k);
-                        bl->type = (block_type)l->read<unsigned char>(read);
-                        chunk_read += read;
-                    }
-                }
+            sc.types.resize(size);
+            for (auto &t : sc.types) {
+                t = l->read<unsigned char>(read);
+                chunk_read += read;
             }
         } else if (type == fourcc("SURF")) {
-            assert(size == sizeof(unsigned char) * face_count * CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE);
-
-            for (auto k = 0u; k < CHUNK_SIZE; k++) {
-                for (auto j = 0u; j < CHUNK_SIZE; j++) {
-                    for (auto i = 0u; i < CHUNK_SIZE; i++) {
-                        ch->blocks.get(i, j, k);
-                        auto bl = ch->blocks.get(i, j, k);
-                        for (auto &surf : bl->surfs) {
-                            surf = (surface_type)l->read<unsigned char>(read);
-                            chunk_read += read;
-                        }
-                    }
-                }
+            sc.surfs.resize(size);
+            for (auto &surf : sc.surfs) {
+                surf = l->read<unsigned char>(read);
+                chunk_read += read;
             }
         } else if (type == fourcc("WIRE")) {
-            assert(size == sizeof(unsigned char) * face_count * CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE);
-
-            for (auto k = 0u; k < CHUNK_SIZE; k++) {
-                for (auto j = 0u; j < CHUNK_SIZE; j++) {
-                    for (auto i = 0u; i < CHUNK_SIZE; i++) {
-                        ch->blocks.get(i, j, k);
-                        auto bl = ch->blocks.get(i, j, k);
-                        for (auto &has_wire : bl->has_wire) {
-                            has_wire = (bool)l->read<unsigned char>(read);
-                            chunk_read += read;
-                        }
-                    }
-                }
+            sc.wires.resize(size);
+            for (auto &wire : sc.wires) {
+                wire = l->read<unsigned char>(read);
+                chunk_read += read;
             }
         } else if (type == fourcc("CONN")) {
-            assert(size == sizeof(uint32_t) * face_count * CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE);
-
-            for (auto k = 0u; k < CHUNK_SIZE; k++) {
-                for (auto j = 0u; j < CHUNK_SIZE; j++) {
-                    for (auto i = 0u; i < CHUNK_SIZE; i++) {
-                        ch->blocks.get(i, j, k);
-                        auto bl = ch->blocks.get(i, j, k);
-                        for (auto &wire_bit : bl->wire_bits) {
-                            wire_bit = l->read<uint32_t>(read);
-                            chunk_read += read;
-                        }
-                    }
-                }
+            sc.conns.resize(size / sizeof(uint32_t));
+            for (auto &conn : sc.conns) {
+                conn = l->read<uint32_t>(read);
+                chunk_read += read;
             }
         }
     }
-    ch->dirty();
-    ship->chunks.insert({chunk_pos, ch});
-    ship->mins = glm::min(ship->mins, chunk_pos);
-    ship->maxs = glm::max(ship->maxs, chunk_pos);
 
     return chunk_read;
 }
 
+/* does saved block index have nothing but its type? */
+static bool is_plain(saved_chunk const &sc, unsigned index) {
+    for (auto f = 0u; f < face_count; f++) {
+        auto i = face_count * index + f;
+        if (sc.surfs[i] ||
+            (!sc.wires.empty() && sc.wires[i]) ||
+            (!sc.conns.empty() && sc.conns[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void place_chunk(ship_space *ship, saved_chunk const &sc) {
+    auto n = sc.n;
+    auto blocks = n * n * n;
+
+    if (sc.uniform) {
+        /* lines up with one of ours: that chunk just takes the type */
+        if (n == CHUNK_SIZE) {
+            chunk *ch = ship->ensure_chunk(sc.pos);
+            if (ch->is_uniform()) {
+                ch->uniform_type = (block_type)sc.uniform_type;
+                return;
+            }
+        }
+
+        /* otherwise spread it over the blocks it covers, as if it had
+         * been saved in full */
+        saved_chunk full;
+        full.pos = sc.pos;
+        full.n = n;
+        full.types.assign(blocks, sc.uniform_type);
+        full.surfs.assign(face_count * blocks, 0);
+        place_chunk(ship, full);
+        return;
+    }
+
+    assert(sc.types.size() == blocks);
+    assert(sc.surfs.size() == face_count * blocks);
+    assert(sc.wires.empty() || sc.wires.size() == face_count * blocks);
+    assert(sc.conns.empty() || sc.conns.size() == face_count * blocks);
+
+    /* a saved chunk which is uniform, and lines up with one of ours, just
+     * sets that chunk's type. */
+    if (n == CHUNK_SIZE) {
+        auto uniform = true;
+        for (auto index = 0u; index < blocks && uniform; index++) {
+            uniform = sc.types[index] == sc.types[0] && is_plain(sc, index);
+        }
+
+        chunk *ch = ship->ensure_chunk(sc.pos);
+        if (uniform && ch->is_uniform()) {
+            ch->uniform_type = (block_type)sc.types[0];
+            return;
+        }
+    }
+
+    /* blocks are stored x-fastest within the saved chunk */
+    auto index = 0u;
+    for (auto k = 0u; k < n; k++) {
+        for (auto j = 0u; j < n; j++) {
+            for (auto i = 0u; i < n; i++) {
+                auto p = (int)n * sc.pos + glm::ivec3(i, j, k);
+
+                /* don't expand a uniform chunk just to write what it
+                 * already holds */
+                chunk *ch = ship->ensure_chunk(ship->get_chunk_coord_containing(p));
+                if (ch->is_uniform() && sc.types[index] == ch->uniform_type && is_plain(sc, index)) {
+                    index++;
+                    continue;
+                }
+
+                auto bl = ship->ensure_block(p);
+
+                *bl.type = (block_type)sc.types[index];
+                *bl.wire_mask = 0;
+                for (auto f = 0u; f < face_count; f++) {
+                    bl.surfs[f] = (surface_type)sc.surfs[face_count * index + f];
+                    if (!sc.wires.empty()) {
+                        bl.set_has_wire(f, sc.wires[face_count * index + f] != 0);
+                    }
+                    bl.wire_bits[f] = sc.conns.empty() ? 0 : (unsigned char)sc.conns[face_count * index + f];
+                }
+
+                index++;
+            }
+        }
+    }
+}
+
 static uint32_t load_zone(loader *l, std::vector<std::pair<glm::ivec3, zone_info>> &zones) {
     uint32_t read = 0;
     uint32_t zone_read = 0;
@@ -202,13 +286,14 @@ static void load_ship(loader *l, ship_space *ship) {
     auto ship_read = 0u;
     assert(ship_size > 0);
 
+    std::vector<saved_chunk> chunks;
     std::vector<std::pair<glm::ivec3, zone_info>> zones;
 
     while (ship_read < ship_size) {
         auto type = l->read_type(read);
         ship_read += read;
         if (type == fourcc("CHNK")) {
-            ship_read += load_chunk(l, ship);
+            ship_read += load_chunk(l, chunks);
         } else if (type == fourcc("ZONE")) {
             ship_read += load_zone(l, zones);
         } else {
@@ -223,13 +308,41 @@ static void load_ship(loader *l, ship_space *ship) {
         }
     }
 
+    /* now we know which chunks the ship covers at our own chunk size, get
+     * the memory for all of them at once. */
+    std::unordered_set<glm::ivec3, ivec3_hash> covered;
+    for (auto &sc : chunks) {
+        glm::ivec3 a = (int)sc.n * sc.pos;
+        glm::ivec3 b = a + glm::ivec3((int)sc.n - 1);
+        glm::ivec3 ca, cb;
+        split_coord(a.x, nullptr, &ca.x);
+        split_coord(a.y, nullptr, &ca.y);
+        split_coord(a.z, nullptr, &ca.z);
+        split_coord(b.x, nullptr, &cb.x);
+        split_coord(b.y, nullptr, &cb.y);
+        split_coord(b.z, nullptr, &cb.z);
+
+        for (auto k = ca.z; k <= cb.z; k++) {
+            for (auto j = ca.y; j <= cb.y; j++) {
+                for (auto i = ca.x; i <= cb.x; i++) {
+                    covered.insert(glm::ivec3(i, j, k));
+                }
+            }
+        }
+    }
+    ship->chunk_storage.reserve(covered.size());
+
+    for (auto &sc : chunks) {
+        place_chunk(ship, sc);
+    }
+
     ship->rebuild_topology();
     for (auto zone : zones) {
         topo_info *t = topo_find(ship->get_topo_info(zone.first));
         zone_info *z = ship->get_zone_info(t);
         if (!z) {
             /* if there wasn't a zone, make one */
-            ship->zones[t] = new zone_info(zone.second);
+            *ship->ensure_zone(t) = zone.second;
         }
         else {
             // weird if we're here?
@@ -115,6 +115,7 @@ upload_mesh(sw_mesh *mesh)
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh->num_indices * sizeof(unsigned), mesh->indices, GL_STATIC_DRAW);
 
     ret->num_indices = mesh->num_indices;
+    ret->index_type = GL_UNSIGNED_INT;
 
     printf("upload_mesh: %p num_indices=%d vram_size=%.1fKB\n", ret,
             ret->num_indices, (mesh->num_vertices * sizeof(vertex) + mesh->num_indices * sizeof(unsigned)) / 1024.0f);
@@ -122,12 +123,46 @@ upload_mesh(sw_mesh *mesh)
     return ret;
 }
 
+hw_mesh *
+upload_chunk_mesh(chunk_sw_mesh *mesh)
+{
+    hw_mesh *ret = new hw_mesh;
+
+    glGenVertexArrays(1, &ret->vao);
+    glBindVertexArray(ret->vao);
+
+    glGenBuffers(1, &ret->vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, ret->vbo);
+    glBufferData(GL_ARRAY_BUFFER, mesh->num_vertices * sizeof(chunk_vertex), mesh->verts, GL_STATIC_DRAW);
+
+    /* not normalized: the chunk's world matrix undoes the fixed point */
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_SHORT, GL_FALSE, sizeof(chunk_vertex), (GLvoid const *)offsetof(chunk_vertex, x));
+
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(chunk_vertex), (GLvoid const *)offsetof(chunk_vertex, normal_packed));
+
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 1, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(chunk_vertex), (GLvoid const *)offsetof(chunk_vertex, u));
+
+    size_t index_size = mesh->short_indices ? sizeof(uint16_t) : sizeof(unsigned);
+    glGenBuffers(1, &ret->ibo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ret->ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh->num_indices * index_size,
+                 mesh->short_indices ? (void const *)mesh->short_indices : (void const *)mesh->indices, GL_STATIC_DRAW);
+
+    ret->num_indices = mesh->num_indices;
+    ret->index_type = mesh->short_indices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    return ret;
+}
+
 
 void
 draw_mesh(hw_mesh *m)
 {
     glBindVertexArray(m->vao);
-    glDrawElements(GL_TRIANGLES, m->num_indices, GL_UNSIGNED_INT, nullptr);
+    glDrawElements(GL_TRIANGLES, m->num_indices, m->index_type, nullptr);
 }
 
 
@@ -136,7 +171,7 @@ draw_mesh_instanced(hw_mesh *m, unsigned num_instances)
 {
     glBindVertexArray(m->vao);
     glDrawElementsInstanced(GL_TRIANGLES, m->num_indices,
-                            GL_UNSIGNED_INT, nullptr, num_instances);
+                            m->index_type, nullptr, num_instances);
 }
 
 
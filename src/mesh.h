@@ -1,5 +1,6 @@
 #pragma once
 
+#include <math.h>
 #include <string>
 #include <glm/glm.hpp>
 #include <glm/gtc/packing.hpp>
@@ -15,6 +16,7 @@ struct hw_mesh {
     GLuint ibo;
     GLuint vao;
     GLuint num_indices;
+    GLenum index_type;      /* GL_UNSIGNED_INT, or GL_UNSIGNED_SHORT */
 };
 
 
@@ -41,8 +43,49 @@ struct sw_mesh {
     unsigned int num_indices;
 };
 
+/* the vertex format of chunk meshes, which are most of what is drawn.
+ * positions are chunk-local fixed point, in 1/chunk_vertex_scale of a
+ * block; the chunk's world matrix scales them back down. of the uv only u
+ * is kept, which is all the chunk shader reads: it picks the palette
+ * entry.
+ */
+static float const chunk_vertex_scale = 256.0f;
+
+struct chunk_vertex {
+    int16_t x, y, z;
+    uint16_t u;
+    uint32_t normal_packed;
+
+    chunk_vertex() = default;
+
+    explicit chunk_vertex(vertex const &v)
+        : x((int16_t)roundf(v.x * chunk_vertex_scale)),
+          y((int16_t)roundf(v.y * chunk_vertex_scale)),
+          z((int16_t)roundf(v.z * chunk_vertex_scale)),
+          u((uint16_t)(v.uv_packed & 0xffff)),
+          normal_packed(v.normal_packed)
+    {
+    }
+
+    glm::vec3 pos() const {
+        return glm::vec3(x, y, z) / chunk_vertex_scale;
+    }
+};
+
+/* a chunk mesh, in chunk_vertex form. where there are few enough vertices
+ * for them, short_indices holds the indices as 16 bits; otherwise it is
+ * null and indices is used. */
+struct chunk_sw_mesh {
+    chunk_vertex *verts;
+    unsigned int *indices;
+    uint16_t *short_indices;
+    unsigned int num_vertices;
+    unsigned int num_indices;
+};
+
 sw_mesh *load_mesh(char const *filename);
 hw_mesh *upload_mesh(sw_mesh *mesh);
+hw_mesh *upload_chunk_mesh(chunk_sw_mesh *mesh);
 void draw_mesh(hw_mesh *m);
 void free_mesh(hw_mesh *m);
 void draw_mesh_instanced(hw_mesh *m, unsigned num_instances);
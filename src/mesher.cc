@@ -12,54 +12,13 @@
 
 #include "asset_manager.h"
 #include "chunk.h"
+#include "mesher.h"
+#include "parallel.h"
 
 extern asset_manager asset_man;
 
 extern physics *phy;
 
-static void
-stamp_at_offset(std::vector<vertex> *verts, std::vector<unsigned> *indices,
-                sw_mesh *src, glm::vec3 offset)
-{
-    auto index_base = (unsigned)verts->size();
-
-    for (unsigned int i = 0; i < src->num_vertices; i++) {
-        vertex v = src->verts[i];
-        v.x += offset.x;
-        v.y += offset.y;
-        v.z += offset.z;
-        verts->push_back(v);
-    }
-
-    for (unsigned int i = 0; i < src->num_indices; i++)
-        indices->push_back(index_base + src->indices[i]);
-}
-
-static void
-stamp_at_mat(std::vector<vertex> *verts, std::vector<unsigned> *indices,
-                sw_mesh *src, glm::mat4 mat)
-{
-    auto index_base = (unsigned)verts->size();
-
-    for (unsigned int i = 0; i < src->num_vertices; i++) {
-        auto v = src->verts[i];
-        auto nv = mat * glm::vec4(v.x, v.y, v.z, 1);
-        v.x = nv.x;
-        v.y = nv.y;
-        v.z = nv.z;
-
-        auto norm = glm::unpackSnorm3x10_1x2(v.normal_packed);
-        norm.w = 0;
-        norm = mat * norm;
-        v.normal_packed = glm::packSnorm3x10_1x2(norm);
-
-        verts->push_back(v);
-    }
-
-    for (unsigned int i = 0; i < src->num_indices; i++)
-        indices->push_back(index_base + src->indices[i]);
-}
-
 void build_rigidbody(const glm::mat4 &m, btCollisionShape *shape, btRigidBody **rb) {
     if (*rb) {
         /* We already have a rigid body set up; just swap out its collision shape. */
@@ -91,8 +50,21 @@ void convert_static_rb_to_dynamic(btRigidBody *rb, float mass) {
 }
 
 
-void
-build_static_physics_mesh(sw_mesh const * src, btTriangleMesh **mesh, btCollisionShape **shape)
+static glm::vec3
+vertex_pos(vertex const &v)
+{
+    return glm::vec3(v.x, v.y, v.z);
+}
+
+static glm::vec3
+vertex_pos(chunk_vertex const &v)
+{
+    return v.pos();
+}
+
+template<typename M>
+static void
+build_static_physics_mesh_from(M const * src, btTriangleMesh **mesh, btCollisionShape **shape)
 {
     btTriangleMesh *phys = nullptr;
     btCollisionShape *new_shape = nullptr;
@@ -104,13 +76,11 @@ build_static_physics_mesh(sw_mesh const * src, btTriangleMesh **mesh, btCollisio
         phys->preallocateIndices(src->num_indices);
 
         for (auto x = src->indices; x < src->indices + src->num_indices; /* */) {
-            vertex v1 = src->verts[*x++];
-            vertex v2 = src->verts[*x++];
-            vertex v3 = src->verts[*x++];
+            glm::vec3 v1 = vertex_pos(src->verts[*x++]);
+            glm::vec3 v2 = vertex_pos(src->verts[*x++]);
+            glm::vec3 v3 = vertex_pos(src->verts[*x++]);
 
-            phys->addTriangle(btVector3(v1.x, v1.y, v1.z),
-                btVector3(v2.x, v2.y, v2.z),
-                btVector3(v3.x, v3.y, v3.z));
+            phys->addTriangle(vec3_to_bt(v1), vec3_to_bt(v2), vec3_to_bt(v3));
         }
 
         new_shape = new btBvhTriangleMeshShape(phys, true, true);
@@ -131,6 +101,18 @@ build_static_physics_mesh(sw_mesh const * src, btTriangleMesh **mesh, btCollisio
     *mesh = phys;
 }
 
+void
+build_static_physics_mesh(sw_mesh const * src, btTriangleMesh **mesh, btCollisionShape **shape)
+{
+    build_static_physics_mesh_from(src, mesh, shape);
+}
+
+void
+build_static_physics_mesh(chunk_sw_mesh const * src, btTriangleMesh **mesh, btCollisionShape **shape)
+{
+    build_static_physics_mesh_from(src, mesh, shape);
+}
+
 void
 build_dynamic_physics_mesh(sw_mesh const * src, btCollisionShape **shape)
 {
@@ -177,191 +159,262 @@ teardown_physics_setup(btTriangleMesh **mesh, btCollisionShape **shape, btRigidB
     }
 }
 
-static struct {
-    mesh_data const * frame_mesh;
-    mesh_data const * frame_corner_mesh;
-    mesh_data const * frame_invcorner_mesh;
-    mesh_data const * frame_sloped_mesh;
-    glm::mat4 corner_matrices[8];
-    glm::mat4 sloped_matrices[8];
-    glm::mat4 extra_matrices[4];
-} frame_render_data;
+static mesher_sources sources;
 
 void
 mesher_init()
 {
-    frame_render_data.frame_mesh = &asset_man.get_mesh("frame");
-    frame_render_data.frame_corner_mesh = &asset_man.get_mesh("frame-corner");
-    frame_render_data.frame_invcorner_mesh = &asset_man.get_mesh("frame-invcorner");
-    frame_render_data.frame_sloped_mesh = &asset_man.get_mesh("frame-sloped");
+    sources.frame = asset_man.get_mesh("frame").sw;
+    sources.frame_corner = asset_man.get_mesh("frame-corner").sw;
+    sources.frame_invcorner = asset_man.get_mesh("frame-invcorner").sw;
+    sources.frame_sloped = asset_man.get_mesh("frame-sloped").sw;
 
     static float const rots[] = { 0.f, 90.f, 270.f, 180.f };
 
     for (auto i = 0; i < 8; i++) {
-        frame_render_data.corner_matrices[i] = glm::translate(glm::vec3(0.5f, 0.5f, 0.5f)) *
+        sources.corner_matrices[i] = glm::translate(glm::vec3(0.5f, 0.5f, 0.5f)) *
             glm::eulerAngleZ(glm::radians(rots[i & 3])) *
             glm::eulerAngleY(glm::radians((i & 4) ? 90.f : 0.f)) *
             glm::translate(glm::vec3(-0.5f, -0.5f, -0.5f));
     }
 
     for (auto i = 0; i < 8; i++) {
-        frame_render_data.sloped_matrices[i] = glm::translate(glm::vec3(0.5f, 0.5f, 0.5f)) *
+        sources.sloped_matrices[i] = glm::translate(glm::vec3(0.5f, 0.5f, 0.5f)) *
             glm::eulerAngleZ(glm::radians(rots[i & 3])) *
             glm::eulerAngleY(glm::radians((i & 4) ? 180.f : 0.f)) *
             glm::translate(glm::vec3(-0.5f, -0.5f, -0.5f));
     }
 
     for (auto i = 0; i < 4; i++) {
-        frame_render_data.extra_matrices[i] = glm::translate(glm::vec3(0.5f, 0.5f, 0.5f)) *
+        sources.extra_matrices[i] = glm::translate(glm::vec3(0.5f, 0.5f, 0.5f)) *
             glm::eulerAngleZ(glm::radians(rots[i & 3])) *
             glm::eulerAngleY(glm::radians(90.f)) *
             glm::translate(glm::vec3(-0.5f, -0.5f, -0.5f));
     }
+
+    for (auto &kind : asset_man.surf_kinds) {
+        sources.surfs[kind.first & 0xff] = kind.second.visual_mesh ? kind.second.visual_mesh->sw : nullptr;
+        sources.phys_surfs[kind.first & 0xff] = kind.second.physics_mesh ? kind.second.physics_mesh->sw : nullptr;
+    }
+
+    mesher_bake(&sources);
 }
 
 glm::mat4
 get_corner_matrix(block_type type, glm::ivec3 pos) {
-    glm::mat4 mat;
-    if ((type & ~3) == block_slope_extra_base) {
-        mat = frame_render_data.extra_matrices[type & 3];
+    return mesher_corner_matrix(&sources, type, pos);
+}
+
+void
+chunk_mesh_queue::start(unsigned threads)
+{
+    if (!threads) {
+        threads = std::max(1u, default_thread_count() - 1);
+    }
+
+    stopping = false;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([this]() { work(); });
+    }
+}
+
+void
+chunk_mesh_queue::stop()
+{
+    land(true);
+
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        stopping = true;
     }
-    else if ((type & ~7) == block_slope_base) {
-        mat = frame_render_data.sloped_matrices[type & 7];
+    wake.notify_all();
+
+    for (auto &w : workers) {
+        w.join();
+    }
+    workers.clear();
+
+    for (auto job : spare) {
+        delete job;
+    }
+    spare.clear();
+}
+
+void
+chunk_mesh_queue::submit(chunk *ch, chunk *const nb[face_count])
+{
+    if (!wants(ch)) {
+        return;
+    }
+
+    chunk_mesh_job *job;
+    if (spare.empty()) {
+        job = new chunk_mesh_job;
     }
     else {
-        mat = frame_render_data.corner_matrices[type & 7];
+        job = spare.back();
+        spare.pop_back();
+    }
+
+    job->ch = ch;
+    job->gen = ch->mesh_gen;
+    job->done = false;
+    job->phys_mesh = nullptr;
+    job->phys_shape = nullptr;
+
+    /* only the block data is wanted, so leave the rest of snap alone */
+    job->snap.pos = ch->pos;
+    job->snap.uniform_type = ch->uniform_type;
+    job->snap.blocks = nullptr;
+    if (ch->blocks) {
+        job->snap_blocks = *ch->blocks;
+        job->snap.blocks = &job->snap_blocks;
+    }
+    job->snap_shell.fill(nb);
+    job->mesh.clear();
+
+    ch->queued_gen = ch->mesh_gen;
+    open.push_back(job);
+
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        todo.push_back(job);
     }
-    mat[3][0] += pos.x;
-    mat[3][1] += pos.y;
-    mat[3][2] += pos.z;
-    return mat;
+    wake.notify_one();
 }
 
 void
-chunk::prepare_render()
+chunk_mesh_queue::work()
 {
-    if (this->render_chunk.valid)
-        return;     // nothing to do here.
-
-    std::vector<vertex> verts;
-    std::vector<unsigned> indices;
-
-    for (unsigned k = 0; k < CHUNK_SIZE; k++) {
-        for (unsigned j = 0; j < CHUNK_SIZE; j++) {
-            for (unsigned i = 0; i < CHUNK_SIZE; i++) {
-                block *b = this->blocks.get(i, j, k);
-
-                if (b->type == block_frame) {
-                    // TODO: block detail, variants, types, surfaces
-                    stamp_at_offset(&verts, &indices, frame_render_data.frame_mesh->sw, glm::vec3(i, j, k));
-
-                    // Only frame side of surface gets generated
-                    for (unsigned surf = 0; surf < 6; surf++) {
-                        if (b->surfs[surf] != surface_none) {
-                            auto mesh = asset_man.surf_kinds[b->surfs[surf]].visual_mesh;
-                            auto mat = mat_block_surface({i, j, k}, surf ^ 1);
-                            stamp_at_mat(&verts, &indices, mesh->sw, mat);
-                        }
-                    }
-                }
-                else if ((b->type & ~7) == block_corner_base) {
-                    stamp_at_mat(&verts, &indices, frame_render_data.frame_corner_mesh->sw,
-                        get_corner_matrix(b->type, { i, j, k }));
-                }
-                else if ((b->type & ~7) == block_invcorner_base) {
-                    stamp_at_mat(&verts, &indices, frame_render_data.frame_invcorner_mesh->sw,
-                        get_corner_matrix(b->type, { i, j, k }));
-                }
-                else if ((b->type & ~7) == block_slope_base) {
-                    stamp_at_mat(&verts, &indices, frame_render_data.frame_sloped_mesh->sw,
-                        get_corner_matrix(b->type, { i, j, k }));
-                }
-                else if ((b->type & ~3) == block_slope_extra_base) {
-                    stamp_at_mat(&verts, &indices, frame_render_data.frame_sloped_mesh->sw,
-                        get_corner_matrix(b->type, { i, j, k }));
-                }
+    for (;;) {
+        chunk_mesh_job *job;
+
+        {
+            std::unique_lock<std::mutex> lk(lock);
+            wake.wait(lk, [this]() { return stopping || !todo.empty(); });
+            if (todo.empty()) {
+                return;
             }
+
+            job = todo.front();
+            todo.pop_front();
+        }
+
+        build_chunk_mesh(&job->snap, &job->snap_shell, &sources, &job->mesh);
+
+        chunk_sw_mesh m = job->mesh.phys_mesh();
+        build_static_physics_mesh(&m, &job->phys_mesh, &job->phys_shape);
+
+        {
+            std::lock_guard<std::mutex> lk(lock);
+            job->done = true;
         }
+        finished.notify_all();
     }
+}
 
-    /* wrap the vectors in a temporary sw_mesh */
-    sw_mesh m{};
-    m.verts = &verts[0];
-    m.indices = &indices[0];
-    m.num_vertices = (unsigned)verts.size();
-    m.num_indices = (unsigned)indices.size();
+/* put what the worker made for job in place, if it is still wanted */
+static void
+land_job(chunk_mesh_job *job)
+{
+    chunk *ch = job->ch;
+
+    if (job->gen == ch->mesh_gen && !ch->render_chunk.valid) {
+        chunk_sw_mesh m = job->mesh.render_mesh();
 
-    // TODO: try to reuse memory
-    if (this->render_chunk.mesh) {
-        free_mesh(this->render_chunk.mesh);
-        delete this->render_chunk.mesh;
+        if (ch->render_chunk.mesh) {
+            free_mesh(ch->render_chunk.mesh);
+            delete ch->render_chunk.mesh;
+        }
+
+        ch->render_chunk.mesh = upload_chunk_mesh(&m);
+        ch->render_chunk.valid = true;
     }
 
-    this->render_chunk.mesh = upload_mesh(&m);
-    this->render_chunk.valid = true;
-}
+    if (job->gen == ch->mesh_gen && !ch->phys_chunk.valid) {
+        /* the body lets go of the old shape before it is thrown away */
+        std::swap(ch->phys_chunk.phys_mesh, job->phys_mesh);
+        std::swap(ch->phys_chunk.phys_shape, job->phys_shape);
+        ch->phys_chunk.valid = true;
 
+        auto mat = mat_position(glm::vec3(CHUNK_SIZE * ch->pos));
+        build_rigidbody(mat, ch->phys_chunk.phys_shape, &ch->phys_chunk.phys_body);
+    }
+
+    /* whatever wasn't used, or was replaced */
+    delete job->phys_shape;
+    delete job->phys_mesh;
+    job->phys_shape = nullptr;
+    job->phys_mesh = nullptr;
+}
 
+/* everything submitted since the last land() becomes a batch */
 void
-chunk::prepare_phys(int x, int y, int z)
+chunk_mesh_queue::close_batch()
 {
-    if (this->phys_chunk.valid)
-        return;     // nothing to do here.
-
-    std::vector<vertex> verts;
-    std::vector<unsigned> indices;
-
-    for (unsigned k = 0; k < CHUNK_SIZE; k++) {
-        for (unsigned j = 0; j < CHUNK_SIZE; j++) {
-            for (unsigned i = 0; i < CHUNK_SIZE; i++) {
-                block *b = this->blocks.get(i, j, k);
-
-                if (b->type == block_frame) {
-                    // TODO: block detail, variants, types, surfaces
-                    stamp_at_offset(&verts, &indices, frame_render_data.frame_mesh->sw, glm::vec3(i, j, k));
-
-                    // Only generate in blocks that have framing
-                    for (unsigned surf = 0; surf < 6; surf++) {
-                        if (b->surfs[surf] != surface_none) {
-                            auto mesh = asset_man.surf_kinds[b->surfs[surf]].physics_mesh;
-                            auto mat = mat_block_surface({i, j, k}, surf ^ 1);
-                            stamp_at_mat(&verts, &indices, mesh->sw, mat);
-                        }
-                    }
-                }
-                else if ((b->type & ~7) == block_corner_base) {
-                    stamp_at_mat(&verts, &indices, frame_render_data.frame_corner_mesh->sw,
-                        get_corner_matrix(b->type, { i, j, k }));
-                }
-                else if ((b->type & ~7) == block_invcorner_base) {
-                    stamp_at_mat(&verts, &indices, frame_render_data.frame_invcorner_mesh->sw,
-                        get_corner_matrix(b->type, { i, j, k }));
-                }
-                else if ((b->type & ~7) == block_slope_base) {
-                    stamp_at_mat(&verts, &indices, frame_render_data.frame_sloped_mesh->sw,
-                        get_corner_matrix(b->type, { i, j, k }));
-                }
-                else if ((b->type & ~3) == block_slope_extra_base) {
-                    stamp_at_mat(&verts, &indices, frame_render_data.frame_sloped_mesh->sw,
-                        get_corner_matrix(b->type, { i, j, k }));
-                }
-            }
+    if (!open.empty()) {
+        batches.push_back(std::move(open));
+        open.clear();
+    }
+}
+
+/* land the oldest batch if it is complete, or with wait, once it is */
+bool
+chunk_mesh_queue::land_oldest(bool wait)
+{
+    auto &batch = batches.front();
+
+    {
+        std::unique_lock<std::mutex> lk(lock);
+        auto all_done = [&batch]() {
+            return std::all_of(batch.begin(), batch.end(),
+                               [](chunk_mesh_job *job) { return job->done; });
+        };
+
+        if (wait) {
+            finished.wait(lk, all_done);
+        }
+        else if (!all_done()) {
+            return false;
         }
     }
 
-    /* wrap the vectors in a temporary sw_mesh */
-    sw_mesh m{};
-    m.verts = &verts[0];
-    m.indices = &indices[0];
-    m.num_vertices = (unsigned)verts.size();
-    m.num_indices = (unsigned)indices.size();
+    for (auto job : batch) {
+        land_job(job);
+        spare.push_back(job);
+    }
+    batches.pop_front();
+    return true;
+}
 
-    this->phys_chunk.valid = true;
+void
+chunk_mesh_queue::land(bool wait)
+{
+    close_batch();
+
+    while (!batches.empty() && land_oldest(wait)) {
+    }
+}
 
-    build_static_physics_mesh(&m,
-        &this->phys_chunk.phys_mesh,
-        &this->phys_chunk.phys_shape);
+void
+chunk_mesh_queue::land_chunk(chunk const *ch)
+{
+    close_batch();
+
+    /* the newest batch with a job for ch */
+    size_t through = 0;
+    for (size_t i = 0; i < batches.size(); i++) {
+        for (auto job : batches[i]) {
+            if (job->ch == ch) {
+                through = i + 1;
+            }
+        }
+    }
 
-    auto mat = mat_position({CHUNK_SIZE * x, CHUNK_SIZE * y, CHUNK_SIZE * z});
-    build_rigidbody(mat, this->phys_chunk.phys_shape, &this->phys_chunk.phys_body);
+    for (; through; through--) {
+        land_oldest(true);
+    }
 }
+
+/* the game only ever uses the one chunk size */
+template struct basic_chunk<CHUNK_SIZE>;
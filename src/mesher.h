@@ -0,0 +1,682 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <glm/glm.hpp>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "chunk.h"
+#include "common.h"
+#include "mesh.h"
+
+/* a set of cells of a block face. the meshes are voxel models, 16 voxels
+ * to the block, so anything lying flat on a face lines up with these.
+ */
+static int const mesher_face_res = 16;
+
+struct mesher_cover {
+    uint64_t bits[mesher_face_res * mesher_face_res / 64] = {};
+
+    void set(int u, int v) {
+        int n = u * mesher_face_res + v;
+        bits[n >> 6] |= 1ull << (n & 63);
+    }
+
+    void add(mesher_cover const &o) {
+        for (int i = 0; i < int(sizeof(bits) / sizeof(*bits)); i++) {
+            bits[i] |= o.bits[i];
+        }
+    }
+
+    /* does this cover all of o, and o cover anything at all? */
+    bool hides(mesher_cover const &o) const {
+        uint64_t any = 0;
+        for (int i = 0; i < int(sizeof(bits) / sizeof(*bits)); i++) {
+            if (o.bits[i] & ~bits[i]) {
+                return false;
+            }
+            any |= o.bits[i];
+        }
+        return any != 0;
+    }
+};
+
+/* a mesh cut up by which face of the block each of its triangles lies flat
+ * on, facing out, as it is stamped in one orientation. where the block
+ * across a face covers all that lies on it, that part is never seen (nor
+ * reached) and the mesher leaves it out. the parts are already in that
+ * orientation, for a block at the origin, and in chunk vertex form.
+ */
+struct mesher_cut {
+    /* [f]: lying on face f; [face_count]: everything else */
+    std::vector<chunk_vertex> verts[face_count + 1];
+    std::vector<unsigned> indices[face_count + 1];
+
+    /* the cells of each face whose centres that face's part covers, which
+     * is what it hides of whatever is against it; and every cell the part
+     * touches at all, which must all be hidden for it to be left out */
+    mesher_cover cover[face_count];
+    mesher_cover reach[face_count];
+
+    chunk_sw_mesh part(int g) const {
+        return chunk_sw_mesh{ const_cast<chunk_vertex *>(verts[g].data()), const_cast<unsigned *>(indices[g].data()),
+                              nullptr, (unsigned)verts[g].size(), (unsigned)indices[g].size() };
+    }
+};
+
+/* the source geometry the chunk mesher stamps into a chunk's meshes.
+ * render and physics geometry differ only in which surface meshes are
+ * used; everything else is shared.
+ */
+struct mesher_sources {
+    sw_mesh const *frame;
+    sw_mesh const *frame_corner;
+    sw_mesh const *frame_invcorner;
+    sw_mesh const *frame_sloped;
+
+    /* indexed by surface_type; null if that surface has no mesh */
+    sw_mesh const *surfs[256];
+    sw_mesh const *phys_surfs[256];
+
+    glm::mat4 corner_matrices[8];
+    glm::mat4 sloped_matrices[8];
+    glm::mat4 extra_matrices[4];
+
+    /* everything above, baked by mesher_bake() into each orientation it
+     * is stamped in, so that stamping only has to move it into place.
+     *
+     * the frame and surfaces are cut up by face, see mesher_cut. a
+     * surface's are [face_count], one for each face of the block it might
+     * be on; null if it has no mesh. */
+    mesher_cut const *frame_cut;
+    mesher_cut const *surf_cuts[256];
+    mesher_cut const *phys_surf_cuts[256];
+
+    /* indexed by block_type; null if that type has no shape */
+    chunk_sw_mesh const *shapes[256];
+};
+
+/* offset is in whole blocks */
+static inline void
+stamp_at_offset(std::vector<chunk_vertex> *verts, std::vector<unsigned> *indices,
+                chunk_sw_mesh const *src, glm::ivec3 offset)
+{
+    auto index_base = (unsigned)verts->size();
+    auto d = offset * (int)chunk_vertex_scale;
+
+    verts->resize(index_base + src->num_vertices);
+    chunk_vertex *to = verts->data() + index_base;
+    for (unsigned int i = 0; i < src->num_vertices; i++) {
+        chunk_vertex v = src->verts[i];
+        v.x = (int16_t)(v.x + d.x);
+        v.y = (int16_t)(v.y + d.y);
+        v.z = (int16_t)(v.z + d.z);
+        to[i] = v;
+    }
+
+    auto first = indices->size();
+    indices->resize(first + src->num_indices);
+    unsigned *ix = indices->data() + first;
+    for (unsigned int i = 0; i < src->num_indices; i++)
+        ix[i] = index_base + src->indices[i];
+}
+
+/* v, with mat applied to its position and normal */
+static inline vertex
+mesher_transform(vertex v, glm::mat4 const &mat)
+{
+    auto nv = mat * glm::vec4(v.x, v.y, v.z, 1);
+    v.x = nv.x;
+    v.y = nv.y;
+    v.z = nv.z;
+
+    auto norm = glm::unpackSnorm3x10_1x2(v.normal_packed);
+    norm.w = 0;
+    norm = mat * norm;
+    v.normal_packed = glm::packSnorm3x10_1x2(norm);
+
+    return v;
+}
+
+/* the transform for a shaped (corner, slope..) block of this type at pos */
+static inline glm::mat4
+mesher_corner_matrix(mesher_sources const *src, block_type type, glm::ivec3 pos)
+{
+    glm::mat4 mat;
+    if ((type & ~3) == block_slope_extra_base) {
+        mat = src->extra_matrices[type & 3];
+    }
+    else if ((type & ~7) == block_slope_base) {
+        mat = src->sloped_matrices[type & 7];
+    }
+    else {
+        mat = src->corner_matrices[type & 7];
+    }
+    mat[3][0] += pos.x;
+    mat[3][1] += pos.y;
+    mat[3][2] += pos.z;
+    return mat;
+}
+
+/* mark the cells of the block face on `axis` which the triangle p covers
+ * the centre of in cover, and those it overlaps at all in reach */
+static inline void
+mesher_cover_triangle(mesher_cover *cover, mesher_cover *reach, glm::vec3 const p[3], int axis)
+{
+    int u = (axis + 1) % 3, v = (axis + 2) % 3;
+    glm::vec2 t[3] = {
+        glm::vec2(p[0][u], p[0][v]), glm::vec2(p[1][u], p[1][v]), glm::vec2(p[2][u], p[2][v])
+    };
+
+    auto cross = [](glm::vec2 s, glm::vec2 t) { return s.x * t.y - s.y * t.x; };
+    float area = cross(t[1] - t[0], t[2] - t[0]);
+    if (fabsf(area) < 1e-9f) {
+        return;
+    }
+
+    /* which side of edge e q is on; > 0 is inside */
+    float const sign = area > 0 ? 1.0f : -1.0f;
+    auto inside = [&](int e, glm::vec2 q) {
+        return sign * cross(t[(e + 1) % 3] - t[e], q - t[e]);
+    };
+
+    float const eps = 1e-5f;
+    float const step = 1.0f / mesher_face_res;
+    glm::vec2 lo = glm::min(glm::min(t[0], t[1]), t[2]);
+    glm::vec2 hi = glm::max(glm::max(t[0], t[1]), t[2]);
+
+    for (int cu = 0; cu < mesher_face_res; cu++) {
+        for (int cv = 0; cv < mesher_face_res; cv++) {
+            glm::vec2 c0(cu * step, cv * step), c1 = c0 + glm::vec2(step);
+            if (hi.x <= c0.x + eps || lo.x >= c1.x - eps || hi.y <= c0.y + eps || lo.y >= c1.y - eps) {
+                continue;
+            }
+
+            /* the cell is clear of the triangle if it is wholly outside
+             * any one edge */
+            glm::vec2 corners[4] = { c0, glm::vec2(c1.x, c0.y), glm::vec2(c0.x, c1.y), c1 };
+            bool clear = false;
+            for (int e = 0; e < 3 && !clear; e++) {
+                clear = true;
+                for (auto q : corners) {
+                    clear = clear && inside(e, q) <= eps;
+                }
+            }
+            if (clear) {
+                continue;
+            }
+
+            reach->set(cu, cv);
+
+            glm::vec2 q = c0 + glm::vec2(0.5f * step);
+            if (inside(0, q) >= 0 && inside(1, q) >= 0 && inside(2, q) >= 0) {
+                cover->set(cu, cv);
+            }
+        }
+    }
+}
+
+/* where v is in verts, adding it if it isn't yet. the meshes come with
+ * every corner of every triangle as a vertex of its own, so this about
+ * halves how many there are. */
+static inline unsigned
+mesher_weld(std::vector<chunk_vertex> *verts, std::map<std::pair<uint64_t, uint32_t>, unsigned> *seen,
+            chunk_vertex v)
+{
+    auto key = std::make_pair((uint64_t)(uint16_t)v.x | (uint64_t)(uint16_t)v.y << 16 |
+                              (uint64_t)(uint16_t)v.z << 32 | (uint64_t)v.u << 48, v.normal_packed);
+
+    auto it = seen->find(key);
+    if (it != seen->end()) {
+        return it->second;
+    }
+
+    auto index = (unsigned)verts->size();
+    verts->push_back(v);
+    (*seen)[key] = index;
+    return index;
+}
+
+/* cut src, as it is when stamped with mat at the origin, into out */
+static inline void
+mesher_cut_mesh(sw_mesh const *src, glm::mat4 const &mat, mesher_cut *out)
+{
+    float const eps = 1e-3f;
+    std::map<std::pair<uint64_t, uint32_t>, unsigned> seen[face_count + 1];
+
+    for (unsigned t = 0; t + 2 < src->num_indices; t += 3) {
+        unsigned const *tri = src->indices + t;
+        glm::vec3 p[3];
+        for (int n = 0; n < 3; n++) {
+            vertex const &v = src->verts[tri[n]];
+            p[n] = glm::vec3(mat * glm::vec4(v.x, v.y, v.z, 1));
+        }
+
+        /* front faces wind counterclockwise */
+        glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+        int g = face_count;
+        for (int f = 0; f < int(face_count); f++) {
+            int axis = f >> 1;
+            float plane = (f & 1) ? 0.0f : 1.0f;
+            float facing = (f & 1) ? -normal[axis] : normal[axis];
+
+            if (facing > 0 && fabsf(p[0][axis] - plane) < eps &&
+                    fabsf(p[1][axis] - plane) < eps && fabsf(p[2][axis] - plane) < eps) {
+                g = f;
+                break;
+            }
+        }
+
+        for (int n = 0; n < 3; n++) {
+            chunk_vertex v(mesher_transform(src->verts[tri[n]], mat));
+            out->indices[g].push_back(mesher_weld(&out->verts[g], &seen[g], v));
+        }
+
+        if (g < int(face_count)) {
+            mesher_cover_triangle(&out->cover[g], &out->reach[g], p, g >> 1);
+        }
+    }
+}
+
+/* bake src's meshes into every orientation they are stamped in: cut up
+ * the frame and surfaces, and turn each shaped block type's mesh. what
+ * this makes lives as long as the program; a mesh used for more than one
+ * thing is only cut once.
+ */
+static inline void
+mesher_bake(mesher_sources *src)
+{
+    auto *frame = new mesher_cut;
+    mesher_cut_mesh(src->frame, glm::mat4(1.0f), frame);
+    src->frame_cut = frame;
+
+    std::unordered_map<sw_mesh const *, mesher_cut const *> done;
+    auto cut_surface = [&done](sw_mesh const *mesh) -> mesher_cut const * {
+        if (!mesh) {
+            return nullptr;
+        }
+
+        auto it = done.find(mesh);
+        if (it != done.end()) {
+            return it->second;
+        }
+
+        auto *cuts = new mesher_cut[face_count];
+        for (int f = 0; f < int(face_count); f++) {
+            mesher_cut_mesh(mesh, mat_block_surface(glm::vec3(0), f ^ 1), &cuts[f]);
+        }
+        done[mesh] = cuts;
+        return cuts;
+    };
+
+    for (int t = 0; t < 256; t++) {
+        src->surf_cuts[t] = cut_surface(src->surfs[t]);
+        src->phys_surf_cuts[t] = cut_surface(src->phys_surfs[t]);
+    }
+
+    for (int t = 0; t < 256; t++) {
+        sw_mesh const *shape = nullptr;
+        if ((t & ~7) == block_corner_base) {
+            shape = src->frame_corner;
+        }
+        else if ((t & ~7) == block_invcorner_base) {
+            shape = src->frame_invcorner;
+        }
+        else if ((t & ~7) == block_slope_base || (t & ~3) == block_slope_extra_base) {
+            shape = src->frame_sloped;
+        }
+
+        src->shapes[t] = nullptr;
+        if (!shape) {
+            continue;
+        }
+
+        glm::mat4 mat = mesher_corner_matrix(src, (block_type)t, glm::ivec3(0));
+        std::vector<chunk_vertex> verts;
+        std::map<std::pair<uint64_t, uint32_t>, unsigned> seen;
+        auto *indices = new unsigned[shape->num_indices];
+        for (unsigned i = 0; i < shape->num_indices; i++) {
+            chunk_vertex v(mesher_transform(shape->verts[shape->indices[i]], mat));
+            indices[i] = mesher_weld(&verts, &seen, v);
+        }
+
+        auto *baked = new chunk_sw_mesh{ new chunk_vertex[verts.size()], indices, nullptr,
+                                         (unsigned)verts.size(), shape->num_indices };
+        std::copy(verts.begin(), verts.end(), baked->verts);
+        src->shapes[t] = baked;
+    }
+}
+
+/* the blocks just outside a chunk, one layer deep all round: what the
+ * mesher needs to know whether the blocks on the chunk's edge are hidden.
+ * [f][a][b] is the block across face f, at a and b along the two other
+ * axes, taken in x, y, z order after f's own.
+ */
+template<int N>
+struct basic_chunk_shell {
+    block_type types[face_count][N][N];
+    surface_type surfs[face_count][N][N][face_count];
+
+    /* copy in the layer of each neighbour which touches the chunk. nb[f]
+     * is the chunk across face f, or null if there is none. */
+    void fill(basic_chunk<N> *const nb[face_count]) {
+        for (int f = 0; f < int(face_count); f++) {
+            int axis = f >> 1;
+            int u = (axis + 1) % 3, v = (axis + 2) % 3;
+
+            for (int a = 0; a < N; a++) {
+                for (int b = 0; b < N; b++) {
+                    if (!nb[f]) {
+                        types[f][a][b] = block_untouched;
+                        std::fill(surfs[f][a][b], surfs[f][a][b] + face_count, surface_none);
+                        continue;
+                    }
+
+                    glm::ivec3 p;
+                    p[axis] = (f & 1) ? N - 1 : 0;
+                    p[u] = a;
+                    p[v] = b;
+                    const_block bl = nb[f]->peek_block(p.x, p.y, p.z);
+                    types[f][a][b] = *bl.type;
+                    std::copy(bl.surfs, bl.surfs + face_count, surfs[f][a][b]);
+                }
+            }
+        }
+    }
+};
+
+typedef basic_chunk_shell<CHUNK_SIZE> chunk_shell;
+
+/* the type and surfaces of the block at p, which may be just outside ch
+ * across one of its faces; outside with no shell is untouched */
+template<int N>
+static inline block_type
+mesher_peek(basic_chunk<N> *ch, basic_chunk_shell<N> const *shell, glm::ivec3 p,
+            surface_type const **surfs)
+{
+    for (int axis = 0; axis < 3; axis++) {
+        if (p[axis] < 0 || p[axis] >= N) {
+            if (!shell) {
+                *surfs = uniform_blocks.surfs;
+                return block_untouched;
+            }
+
+            int f = 2 * axis + (p[axis] < 0);
+            int a = p[(axis + 1) % 3], b = p[(axis + 2) % 3];
+            *surfs = shell->surfs[f][a][b];
+            return shell->types[f][a][b];
+        }
+    }
+
+    const_block bl = ch->peek_block(p.x, p.y, p.z);
+    *surfs = bl.surfs;
+    return *bl.type;
+}
+
+/* a chunk's render and physics geometry, from one pass over its blocks.
+ * both index the one vertex array: the render vertices come first, and
+ * are all that needs uploading; after them are the vertices which only
+ * physics uses, where a surface collides as something other than it looks.
+ * keep one of these around and clear() it between chunks, so that it
+ * stops allocating once it has grown to fit.
+ */
+struct chunk_mesh_buffers {
+    std::vector<chunk_vertex> verts;
+    std::vector<unsigned> indices;          /* render triangles */
+    std::vector<unsigned> phys_indices;     /* physics triangles */
+    unsigned num_render_verts = 0;
+
+    /* the render triangles again as 16 bits, if they fit */
+    std::vector<uint16_t> short_indices;
+
+    /* the physics-only geometry, until it is moved onto the end */
+    std::vector<chunk_vertex> phys_verts;
+    std::vector<unsigned> phys_own_indices;
+
+    void clear() {
+        verts.clear();
+        indices.clear();
+        phys_indices.clear();
+        num_render_verts = 0;
+        short_indices.clear();
+        phys_verts.clear();
+        phys_own_indices.clear();
+    }
+
+    bool short_fits() const {
+        return num_render_verts <= 0x10000;
+    }
+
+    chunk_sw_mesh render_mesh() {
+        return chunk_sw_mesh{ verts.data(), indices.data(), short_fits() ? short_indices.data() : nullptr,
+                              num_render_verts, (unsigned)indices.size() };
+    }
+
+    chunk_sw_mesh phys_mesh() {
+        return chunk_sw_mesh{ verts.data(), phys_indices.data(), nullptr,
+                              (unsigned)verts.size(), (unsigned)phys_indices.size() };
+    }
+};
+
+/* the triangles stamped since `from` are physics geometry too */
+static inline void
+mesher_share(chunk_mesh_buffers *out, size_t from)
+{
+    out->phys_indices.insert(out->phys_indices.end(), out->indices.begin() + from, out->indices.end());
+}
+
+/* stamp part at offset into the render geometry, the physics geometry,
+ * both or neither */
+static inline void
+mesher_emit(chunk_mesh_buffers *out, chunk_sw_mesh const *part, glm::ivec3 offset, bool render, bool phys)
+{
+    if (!part->num_indices) {
+        return;
+    }
+
+    if (render) {
+        size_t from = out->indices.size();
+        stamp_at_offset(&out->verts, &out->indices, part, offset);
+        if (phys) {
+            mesher_share(out, from);
+        }
+    }
+    else if (phys) {
+        stamp_at_offset(&out->phys_verts, &out->phys_own_indices, part, offset);
+    }
+}
+
+/* fill out (which must be clear) with the geometry for every block in ch,
+ * in chunk-local coordinates. shell holds the blocks around ch, so that
+ * faces against them can be culled too; without one, the chunk's outer
+ * faces are all kept. this only touches the cpu side, so it can be used
+ * (and measured) without a gl context or physics world.
+ */
+template<int N>
+void
+build_chunk_mesh(basic_chunk<N> *ch, basic_chunk_shell<N> const *shell, mesher_sources const *src,
+                 chunk_mesh_buffers *out)
+{
+    /* untouched or empty space has no geometry at all */
+    if (ch->is_uniform() &&
+            (ch->uniform_type == block_untouched || ch->uniform_type == block_empty)) {
+        return;
+    }
+
+    auto *verts = &out->verts;
+    auto *indices = &out->indices;
+
+    for (unsigned k = 0; k < N; k++) {
+        for (unsigned j = 0; j < N; j++) {
+            for (unsigned i = 0; i < N; i++) {
+                const_block b = ch->peek_block(i, j, k);
+                size_t from = indices->size();
+                glm::ivec3 pos(i, j, k);
+
+                if (*b.type == block_frame) {
+                    /* how much of each face the next frame over covers.
+                     * the surfaces in it count too, but differently for
+                     * render and physics when their meshes differ. */
+                    mesher_cover near[face_count], phys_near[face_count];
+                    for (int f = 0; f < int(face_count); f++) {
+                        surface_type const *ns;
+                        if (mesher_peek(ch, shell, pos + surface_index_to_normal(f), &ns) != block_frame) {
+                            near[f] = phys_near[f] = mesher_cover();
+                            continue;
+                        }
+
+                        near[f] = phys_near[f] = src->frame_cut->cover[f ^ 1];
+                        for (int s = 0; s < int(face_count); s++) {
+                            if (ns[s] == surface_none) {
+                                continue;
+                            }
+                            if (auto cuts = src->surf_cuts[ns[s]]) {
+                                near[f].add(cuts[s].cover[f ^ 1]);
+                            }
+                            if (auto cuts = src->phys_surf_cuts[ns[s]]) {
+                                phys_near[f].add(cuts[s].cover[f ^ 1]);
+                            }
+                        }
+                    }
+
+                    // TODO: block detail, variants, types, surfaces
+                    mesher_cut const *frame = src->frame_cut;
+                    for (int g = 0; g <= int(face_count); g++) {
+                        chunk_sw_mesh part = frame->part(g);
+                        bool last = g == int(face_count);
+                        mesher_emit(out, &part, pos, last || !near[g].hides(frame->reach[g]),
+                                    last || !phys_near[g].hides(frame->reach[g]));
+                    }
+
+                    // Only frame side of surface gets generated
+                    for (unsigned surf = 0; surf < 6; surf++) {
+                        if (b.surfs[surf] == surface_none) {
+                            continue;
+                        }
+
+                        auto cuts = src->surf_cuts[b.surfs[surf]];
+                        auto phys_cuts = src->phys_surf_cuts[b.surfs[surf]];
+
+                        if (cuts) {
+                            mesher_cut const &cut = cuts[surf];
+                            for (int g = 0; g <= int(face_count); g++) {
+                                chunk_sw_mesh part = cut.part(g);
+                                bool last = g == int(face_count);
+                                mesher_emit(out, &part, pos, last || !near[g].hides(cut.reach[g]),
+                                            phys_cuts == cuts && (last || !phys_near[g].hides(cut.reach[g])));
+                            }
+                        }
+
+                        if (phys_cuts && phys_cuts != cuts) {
+                            mesher_cut const &cut = phys_cuts[surf];
+                            for (int g = 0; g <= int(face_count); g++) {
+                                chunk_sw_mesh part = cut.part(g);
+                                bool last = g == int(face_count);
+                                mesher_emit(out, &part, pos, false, last || !phys_near[g].hides(cut.reach[g]));
+                            }
+                        }
+                    }
+                }
+                else if (auto shape = src->shapes[*b.type]) {
+                    stamp_at_offset(verts, indices, shape, pos);
+                    mesher_share(out, from);
+                }
+            }
+        }
+    }
+
+    /* and put the physics-only geometry after the render geometry */
+    out->num_render_verts = (unsigned)verts->size();
+    for (auto index : out->phys_own_indices) {
+        out->phys_indices.push_back(out->num_render_verts + index);
+    }
+    verts->insert(verts->end(), out->phys_verts.begin(), out->phys_verts.end());
+
+    if (out->short_fits()) {
+        out->short_indices.assign(indices->begin(), indices->end());
+    }
+}
+
+class btTriangleMesh;
+class btCollisionShape;
+
+/* a remesh of one chunk, done off the main thread. the worker only looks
+ * at snap, a copy of the chunk's blocks taken when it was submitted, and
+ * snap_shell, of the blocks around it; ch itself is only ever touched on
+ * the main thread.
+ */
+struct chunk_mesh_job {
+    chunk *ch;
+    unsigned gen;       /* ch->mesh_gen when snap was taken */
+    bool done;          /* set by the worker, under the queue's lock */
+
+    chunk snap;
+    chunk_blocks snap_blocks;
+    chunk_shell snap_shell;
+
+    /* what the worker made: the geometry, and a collision shape built
+     * from the physics part of it. jobs are reused, so these keep their
+     * capacity from one chunk to the next. */
+    chunk_mesh_buffers mesh;
+    btTriangleMesh *phys_mesh;
+    btCollisionShape *phys_shape;
+};
+
+/* remeshes dirty chunks on a pool of worker threads. the main thread
+ * submits chunks, and later lands what the workers made: the gl upload
+ * and the rigid body's new shape, which are all that is left for it to
+ * do.
+ *
+ * everything submitted between two land()s is landed together, so an edit
+ * which touches several chunks never shows half done; until then each
+ * chunk keeps its old meshes. a result from before the chunk was dirtied
+ * again is thrown away, and the chunk is submitted again.
+ */
+struct chunk_mesh_queue {
+    std::mutex lock;
+    std::condition_variable wake;       /* workers: something to do */
+    std::condition_variable finished;   /* main thread: some job is done */
+    std::deque<chunk_mesh_job *> todo;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+
+    /* main thread only */
+    std::vector<chunk_mesh_job *> open;             /* submitted since the last land() */
+    std::deque<std::vector<chunk_mesh_job *>> batches;
+    std::vector<chunk_mesh_job *> spare;            /* landed, to be reused */
+
+    /* start up to `threads` workers (0 for one per core, less the main
+     * thread's) */
+    void start(unsigned threads = 0);
+
+    /* land everything outstanding, and join the workers */
+    void stop();
+
+    /* does ch need a remesh, and not have one coming? */
+    bool wants(chunk const *ch) const {
+        return !(ch->render_chunk.valid && ch->phys_chunk.valid) && ch->queued_gen != ch->mesh_gen;
+    }
+
+    /* queue a remesh of ch, if it wants one. nb[f] is the chunk across
+     * face f, or null */
+    void submit(chunk *ch, chunk *const nb[face_count]);
+
+    /* land every batch which is complete, oldest first, stopping at the
+     * first which isn't; or with wait, wait for and land all of them */
+    void land(bool wait);
+
+    /* wait for and land every batch up to the one with ch's job in it,
+     * for when ch's new collision shape is wanted straight away. the
+     * work is still done on the workers. */
+    void land_chunk(chunk const *ch);
+
+    void close_batch();
+    bool land_oldest(bool wait);
+    void work();
+};
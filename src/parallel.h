@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+/* number of threads to use when asked for 0: one per core */
+static inline unsigned
+default_thread_count()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/* the threads parallel_for() shares its work with. they are started the
+ * first time they are wanted and then kept, asleep between jobs, for the
+ * life of the program -- a parallel_for is often only a few hundred
+ * microseconds of work, and starting threads for each would eat most of
+ * that.
+ *
+ * there is one job at a time. while it is out, anyone else who asks to
+ * share one (another thread, or the job itself) is turned away, and runs
+ * their work on their own.
+ */
+class worker_pool {
+    std::mutex lock;
+    std::condition_variable wake;       /* workers: a job is offered */
+    std::condition_variable finished;   /* owner: the last helper is done */
+    std::vector<std::thread> workers;
+    bool stopping = false;
+    bool busy = false;                  /* a job is out */
+
+    /* the job: run(ctx) does items until there are none left */
+    void (*run)(void *) = nullptr;
+    void *ctx = nullptr;
+    unsigned job = 0;           /* bumped per job, so a worker joins each once */
+    unsigned wanted = 0;        /* more helpers the job could use */
+    unsigned active = 0;        /* helpers in it now */
+
+    void work()
+    {
+        unsigned seen = 0;
+        std::unique_lock<std::mutex> lk(lock);
+        for (;;) {
+            wake.wait(lk, [&]() { return stopping || (wanted && job != seen); });
+            if (stopping) {
+                return;
+            }
+
+            seen = job;
+            wanted--;
+            active++;
+
+            auto f = run;
+            auto c = ctx;
+            lk.unlock();
+            f(c);
+            lk.lock();
+
+            if (!--active) {
+                finished.notify_all();
+            }
+        }
+    }
+
+public:
+    worker_pool() = default;
+    worker_pool(worker_pool const &) = delete;
+    worker_pool &operator=(worker_pool const &) = delete;
+
+    ~worker_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lk(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+
+        for (auto &w : workers) {
+            w.join();
+        }
+    }
+
+    /* run f(c) on the calling thread and on up to `helpers` workers at
+     * once, returning when all of them have. f must share the work out
+     * itself, and cope with helpers turning up after it is all gone.
+     * returns false, having run nothing, if another job is out. */
+    bool share(void (*f)(void *), void *c, unsigned helpers)
+    {
+        {
+            std::lock_guard<std::mutex> lk(lock);
+            if (busy) {
+                return false;
+            }
+
+            busy = true;
+            while (workers.size() < helpers) {
+                workers.emplace_back([this]() { work(); });
+            }
+
+            run = f;
+            ctx = c;
+            job++;
+            wanted = helpers;
+        }
+        wake.notify_all();
+
+        f(c);
+
+        /* no one else may join now; wait for those who did */
+        std::unique_lock<std::mutex> lk(lock);
+        wanted = 0;
+        finished.wait(lk, [&]() { return active == 0; });
+        busy = false;
+        return true;
+    }
+};
+
+/* the one pool every parallel_for shares */
+inline worker_pool &
+parallel_pool()
+{
+    static worker_pool pool;
+    return pool;
+}
+
+/* call f(i) for every i in [0, count), spread over up to `threads` threads
+ * (0 for one per core), the calling thread among them; the others come from
+ * parallel_pool(). items are handed out `grain` at a time, so uneven items
+ * still balance. returns once every item is done; with one thread, too few
+ * items to share, or the pool already busy, it is a plain loop.
+ *
+ * f must be safe to run concurrently with itself on different items.
+ */
+template<typename F>
+void
+parallel_for(size_t count, F const &f, unsigned threads = 0, size_t grain = 1)
+{
+    if (!threads) {
+        threads = default_thread_count();
+    }
+
+    grain = std::max<size_t>(grain, 1);
+    threads = (unsigned)std::min<size_t>(threads, (count + grain - 1) / grain);
+
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        for (;;) {
+            size_t begin = next.fetch_add(grain);
+            if (begin >= count) {
+                return;
+            }
+
+            size_t end = std::min(count, begin + grain);
+            for (size_t i = begin; i < end; i++) {
+                f(i);
+            }
+        }
+    };
+
+    auto run = [](void *w) { (*static_cast<decltype(work) *>(w))(); };
+
+    if (threads <= 1 || !parallel_pool().share(run, &work, threads - 1)) {
+        for (size_t i = 0; i < count; i++) {
+            f(i);
+        }
+    }
+}
@@ -41,6 +41,7 @@ struct physics {
 
 
 struct sw_mesh;
+struct chunk_sw_mesh;
 
 /* Identifies an entity and a mesh/meshpart, to be referenced by the physics system. */
 struct phys_ent_ref
@@ -56,6 +57,9 @@ void convert_static_rb_to_dynamic(btRigidBody *rb, float mass);
 void
 build_static_physics_mesh(sw_mesh const * src, btTriangleMesh **mesh, btCollisionShape **shape);
 
+void
+build_static_physics_mesh(chunk_sw_mesh const * src, btTriangleMesh **mesh, btCollisionShape **shape);
+
 void
 build_dynamic_physics_mesh(sw_mesh const * src, btCollisionShape **shape);
 
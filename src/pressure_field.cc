@@ -0,0 +1,310 @@
+#include <algorithm>
+#include <math.h>
+
+#include "parallel.h"
+#include "pressure_field.h"
+#include "ship_space.h"
+
+/* how fast a change in pressure travels, in blocks a second */
+static float const field_sound_speed = 60.0f;
+
+/* how much of the difference across a face is added to its flow each
+ * substep. a front moves sqrt(this) blocks a substep; anything over 1/3
+ * is unstable. */
+static float const field_push = 0.25f;
+
+/* how much of its flow each face keeps from one substep to the next; the
+ * rest is lost to drag, which is what lets the field settle at all */
+static float const field_keep = 0.995f;
+
+/* differences smaller than this are as good as settled */
+static float const field_settle = 1e-3f;
+
+/* and smaller than this are gone: the tail of a spread would otherwise
+ * creep down into denormals, which are very slow */
+static float const field_floor = 1e-6f;
+
+void
+pressure_field::seed(ship_space *ship, glm::ivec3 p, float dp)
+{
+    if (!enabled || fabsf(dp) < field_settle) {
+        return;
+    }
+
+    int const n = CHUNK_SIZE;
+
+    std::vector<ship_space::component_node> nodes;
+    ship->component_nodes(p, nodes);
+
+    for (auto &node : nodes) {
+        field_chunk *fc = cover(node.ch);
+        float *d = &fc->dev.contents[0][0][0];
+
+        if (node.ch->is_uniform()) {
+            for (int i = 0; i < n * n * n; i++) {
+                d[i] += dp;
+            }
+            continue;
+        }
+
+        /* the blocks of this cell */
+        for (int x = 0; x < n; x++) {
+            for (int y = 0; y < n; y++) {
+                for (int z = 0; z < n; z++) {
+                    if (node.ch->get_topo(x, y, z) == node.t) {
+                        fc->dev.contents[x][y][z] += dp;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* note which faces of each block in fc air passes through */
+static void
+find_open(field_chunk *fc)
+{
+    int const n = CHUNK_SIZE;
+
+    for (int x = 0; x < n; x++) {
+        for (int y = 0; y < n; y++) {
+            for (int z = 0; z < n; z++) {
+                const_block bl = fc->ch->peek_block(x, y, z);
+                for (int f = 0; f < int(face_count); f++) {
+                    fc->open[f].contents[x][y][z] = air_permeable(bl.surfs[f]) ? 1.0f : 0.0f;
+                }
+            }
+        }
+    }
+}
+
+field_chunk *
+pressure_field::cover(chunk *ch)
+{
+    auto it = covered.find(ch);
+    if (it != covered.end()) {
+        return it->second;
+    }
+
+    field_chunk *fc = storage.alloc();
+    fc->ch = ch;
+    find_open(fc);
+    covered[ch] = fc;
+    chunks.push_back(fc);
+    return fc;
+}
+
+/* does anything in fc want to pass through face f into the next chunk? */
+static bool
+spills(field_chunk *fc, int f)
+{
+    int const n = CHUNK_SIZE;
+    int axis = f >> 1;
+    int edge = (f & 1) ? 0 : n - 1;
+
+    for (int u = 0; u < n; u++) {
+        for (int v = 0; v < n; v++) {
+            glm::ivec3 p;
+            p[axis] = edge;
+            p[(axis + 1) % 3] = u;
+            p[(axis + 2) % 3] = v;
+
+            if (fc->open[f].contents[p.x][p.y][p.z] > 0 &&
+                    (fabsf(fc->dev.contents[p.x][p.y][p.z]) >= field_settle ||
+                     fabsf(fc->flow[f].contents[p.x][p.y][p.z]) >= field_settle)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/* push each open face's flow in fc along by the difference across it.
+ * both sides of a face see the same difference, the other way round, so
+ * the flows either side of it stay equal and opposite. */
+static void
+push(pressure_field *field, ship_space *ship, field_chunk *fc)
+{
+    int const n = CHUNK_SIZE;
+    int const m = n + 2;
+
+    /* the chunk with a layer of its neighbours around it; neighbours which
+     * aren't covered are settled, and vacuum is 0 too. */
+    static thread_local std::vector<float> halo;
+    halo.assign(m * m * m, 0.0f);
+    float *hp = halo.data();
+
+    auto h = [hp, m](int x, int y, int z) -> float & {
+        return hp[((x + 1) * m + (y + 1)) * m + (z + 1)];
+    };
+
+    for (int x = 0; x < n; x++) {
+        for (int y = 0; y < n; y++) {
+            std::copy(fc->dev.contents[x][y], fc->dev.contents[x][y] + n, &h(x, y, 0));
+        }
+    }
+
+    for (int f = 0; f < int(face_count); f++) {
+        chunk *nch = ship->get_chunk(fc->ch->pos + surface_index_to_normal(f));
+        auto it = nch ? field->covered.find(nch) : field->covered.end();
+        if (it == field->covered.end()) {
+            continue;
+        }
+
+        /* strides along the face's axis and the two across it, in the
+         * halo and in the chunk */
+        int axis = f >> 1;
+        int const hs[3] = { m * m, m, 1 };
+        int const cs[3] = { n * n, n, 1 };
+        int u = (axis + 1) % 3, v = (axis + 2) % 3;
+
+        float *to = &h(0, 0, 0) + ((f & 1) ? -hs[axis] : n * hs[axis]);
+        float const *from = &it->second->dev.contents[0][0][0] + ((f & 1) ? (n - 1) * cs[axis] : 0);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                to[i * hs[u] + j * hs[v]] = from[i * cs[u] + j * cs[v]];
+            }
+        }
+    }
+
+    /* a row at a time, one face at a time */
+    int const across[face_count] = { m * m, -m * m, m, -m, 1, -1 };
+    for (int f = 0; f < int(face_count); f++) {
+        for (int x = 0; x < n; x++) {
+            for (int y = 0; y < n; y++) {
+                float const *c = &h(x, y, 0);
+                float const *c2 = c + across[f];
+                float const *o = fc->open[f].contents[x][y];
+                float *q = fc->flow[f].contents[x][y];
+
+                for (int z = 0; z < n; z++) {
+                    float v = field_keep * (q[z] + field_push * o[z] * (c[z] - c2[z]));
+                    q[z] = fabsf(v) < field_floor ? 0.0f : v;
+                }
+            }
+        }
+    }
+}
+
+/* move what the faces' flows carry out of each block in fc */
+static void
+drain(field_chunk *fc)
+{
+    int const n = CHUNK_SIZE;
+    float peak = 0;
+
+    for (int x = 0; x < n; x++) {
+        for (int y = 0; y < n; y++) {
+            float *d = fc->dev.contents[x][y];
+            float const *xp = fc->flow[surface_xp].contents[x][y];
+            float const *xm = fc->flow[surface_xm].contents[x][y];
+            float const *yp = fc->flow[surface_yp].contents[x][y];
+            float const *ym = fc->flow[surface_ym].contents[x][y];
+            float const *zp = fc->flow[surface_zp].contents[x][y];
+            float const *zm = fc->flow[surface_zm].contents[x][y];
+
+            for (int z = 0; z < n; z++) {
+                float v = d[z] - (xp[z] + xm[z] + yp[z] + ym[z] + zp[z] + zm[z]);
+                d[z] = fabsf(v) < field_floor ? 0.0f : v;
+            }
+
+            for (int z = 0; z < n; z++) {
+                float q = std::max(std::max(fabsf(xp[z]), fabsf(xm[z])),
+                                   std::max(std::max(fabsf(yp[z]), fabsf(ym[z])),
+                                            std::max(fabsf(zp[z]), fabsf(zm[z]))));
+                peak = std::max(peak, std::max(fabsf(d[z]), q));
+            }
+        }
+    }
+
+    fc->peak = peak;
+}
+
+void
+pressure_field::step(ship_space *ship, float dt, unsigned threads)
+{
+    if (!enabled) {
+        clear();
+        return;
+    }
+
+    if (chunks.empty()) {
+        return;
+    }
+
+    /* walls may have gone up or come down since the last step */
+    parallel_for(chunks.size(), [&](size_t i) {
+        find_open(chunks[i]);
+    }, threads, 16);
+
+    float reach = field_sound_speed * dt;
+    int substeps = std::max(1, (int)ceilf(reach / sqrtf(field_push)));
+
+    for (int s = 0; s < substeps; s++) {
+        /* take on the chunks something is about to spill into */
+        size_t count = chunks.size();
+        for (size_t i = 0; i < count; i++) {
+            field_chunk *fc = chunks[i];
+            for (int f = 0; f < int(face_count); f++) {
+                chunk *nch = ship->get_chunk(fc->ch->pos + surface_index_to_normal(f));
+                if (nch && !covered.count(nch) && spills(fc, f)) {
+                    cover(nch);
+                }
+            }
+        }
+
+        /* every push reads its neighbours' pressures, so all of them are
+         * done before any block's pressure moves */
+        parallel_for(chunks.size(), [&](size_t i) {
+            push(this, ship, chunks[i]);
+        }, threads, 16);
+
+        parallel_for(chunks.size(), [&](size_t i) {
+            drain(chunks[i]);
+        }, threads, 16);
+
+        /* let go of what has settled */
+        for (size_t i = 0; i < chunks.size();) {
+            field_chunk *fc = chunks[i];
+
+            if (fc->peak < field_settle) {
+                covered.erase(fc->ch);
+                storage.free(fc);
+                chunks[i] = chunks.back();
+                chunks.pop_back();
+                continue;
+            }
+
+            i++;
+        }
+    }
+}
+
+float
+pressure_field::deviation(ship_space *ship, glm::ivec3 p)
+{
+    if (chunks.empty()) {
+        return 0.0f;
+    }
+
+    int x, y, z;
+    glm::ivec3 c;
+    split_coord(p.x, &x, &c.x);
+    split_coord(p.y, &y, &c.y);
+    split_coord(p.z, &z, &c.z);
+
+    auto it = covered.find(ship->get_chunk(c));
+    return it == covered.end() ? 0.0f : it->second->dev.contents[x][y][z];
+}
+
+void
+pressure_field::clear()
+{
+    for (auto fc : chunks) {
+        storage.free(fc);
+    }
+
+    chunks.clear();
+    covered.clear();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+#include "chunk.h"
+#include "chunk_pool.h"
+
+struct ship_space;
+
+/* per-block pressure, where a zone is not yet well mixed.
+ *
+ * zones stay the authority on how much gas there is, and still mix the
+ * moment they merge. the field holds, for each block it covers, how far
+ * that block's pressure is from its zone's. when a breach or an opened
+ * door joins zones at different pressures, each side's blocks are given
+ * the difference between what that side had and what the merged zone has.
+ * every air-permeable face then carries a flow, which the difference
+ * across it speeds up and drag slows down, so a breach sends a front
+ * through the zone rather than the whole zone emptying at once. open
+ * vacuum past the last chunk soaks up whatever reaches it.
+ *
+ * only chunks which hold some difference are covered. a chunk is taken on
+ * when a covered one next to it has something to pass into it, and let go
+ * once everything in it has settled, so once all is mixed the field costs
+ * nothing, and off (the default) it is never touched at all.
+ *
+ * a step works on every covered chunk at once over the worker threads.
+ * which faces are open is read off the blocks once a step; each chunk is
+ * then copied into a padded cube with its neighbours' edges around it, so
+ * that the update runs straight along rows.
+ */
+struct field_chunk {
+    chunk *ch;
+    fixed_cube<float, CHUNK_SIZE> open[face_count];   /* 1 where air passes each face, else 0 */
+    fixed_cube<float, CHUNK_SIZE> flow[face_count];   /* out through each face, a substep */
+    fixed_cube<float, CHUNK_SIZE> dev;
+    float peak;     /* the largest |dev| or |flow| after the last substep */
+};
+
+struct pressure_field {
+    bool enabled = false;
+
+    slab_pool<field_chunk> storage;
+    std::unordered_map<chunk *, field_chunk *> covered;
+    std::vector<field_chunk *> chunks;
+
+    /* add dp to the pressure of every block in the component holding
+     * block p, relative to its zone's. only that component is walked, so
+     * a merge costs the size of the zones merging, not of the ship. */
+    void seed(ship_space *ship, glm::ivec3 p, float dp);
+
+    /* move dt seconds' worth, over up to `threads` threads (0 for one
+     * per core) */
+    void step(ship_space *ship, float dt, unsigned threads = 0);
+
+    /* how far the pressure at p is from its zone's */
+    float deviation(ship_space *ship, glm::ivec3 p);
+
+    /* let go of everything */
+    void clear();
+
+    field_chunk *cover(chunk *ch);
+};
@@ -56,20 +56,33 @@ void saver::end_lump(long start) {
 }
 
 static void save_chunk(saver *s, std::pair<glm::ivec3, chunk *> chunk) {
+    auto ch = chunk.second;
+
     auto chunk_lump = s->begin_lump(fourcc("CHNK"));
 
     auto info_lump = s->begin_lump(fourcc("INFO"));
     s->write(chunk.first.x);
     s->write(chunk.first.y);
     s->write(chunk.first.z);
+    s->write<uint32_t>(CHUNK_SIZE);
     s->end_lump(info_lump);
 
+    /* a uniform chunk is nothing but its type. (fourcc() only keeps the
+     * last letter of a tag, so this has to differ from the others'.) */
+    if (ch->is_uniform()) {
+        auto uniform_lump = s->begin_lump(fourcc("FILL"));
+        s->write<unsigned char>(ch->uniform_type);
+        s->end_lump(uniform_lump);
+
+        s->end_lump(chunk_lump);
+        return;
+    }
+
     auto frames_lump = s->begin_lump(fourcc("FRAM"));
     for (auto k = 0u; k < CHUNK_SIZE; k++) {
         for (auto j = 0u; j < CHUNK_SIZE; j++) {
             for (auto i = 0u; i < CHUNK_SIZE; i++) {
-                auto bl = chunk.second->blocks.get(i, j, k);
-                s->write<unsigned char>(bl->type);
+                s->write<unsigned char>(*ch->peek_block(i, j, k).type);
             }
         }
     }
@@ -79,9 +92,9 @@ static void save_chunk(saver *s, std::pair<glm::ivec3, chunk *> chunk) {
     for (auto k = 0u; k < CHUNK_SIZE; k++) {
         for (auto j = 0u; j < CHUNK_SIZE; j++) {
             for (auto i = 0u; i < CHUNK_SIZE; i++) {
-                auto bl = chunk.second->blocks.get(i, j, k);
-                for (auto &surf : bl->surfs) {
-                    s->write<unsigned char>(surf);
+                surface_type const *surfs = ch->peek_block(i, j, k).surfs;
+                for (auto f = 0u; f < face_count; f++) {
+                    s->write<unsigned char>(surfs[f]);
                 }
             }
         }
@@ -92,9 +105,9 @@ static void save_chunk(saver *s, std::pair<glm::ivec3, chunk *> chunk) {
     for (auto k = 0u; k < CHUNK_SIZE; k++) {
         for (auto j = 0u; j < CHUNK_SIZE; j++) {
             for (auto i = 0u; i < CHUNK_SIZE; i++) {
-                auto bl = chunk.second->blocks.get(i, j, k);
-                for (bool f : bl->has_wire) {
-                    s->write<unsigned char>(f);
+                unsigned char mask = *ch->peek_block(i, j, k).wire_mask;
+                for (auto f = 0u; f < face_count; f++) {
+                    s->write<unsigned char>((mask >> f) & 1);
                 }
             }
         }
@@ -105,9 +118,9 @@ static void save_chunk(saver *s, std::pair<glm::ivec3, chunk *> chunk) {
     for (auto k = 0u; k < CHUNK_SIZE; k++) {
         for (auto j = 0u; j < CHUNK_SIZE; j++) {
             for (auto i = 0u; i < CHUNK_SIZE; i++) {
-                auto bl = chunk.second->blocks.get(i, j, k);
-                for (unsigned int wire_bit : bl->wire_bits) {
-                    s->write<uint32_t>(wire_bit);
+                unsigned char const *wire_bits = ch->peek_block(i, j, k).wire_bits;
+                for (auto f = 0u; f < face_count; f++) {
+                    s->write<uint32_t>(wire_bits[f]);
                 }
             }
         }
@@ -117,9 +130,9 @@ static void save_chunk(saver *s, std::pair<glm::ivec3, chunk *> chunk) {
     s->end_lump(chunk_lump);
 }
 
-static void save_zone(saver *s, ship_space *ship, std::pair<topo_info *, zone_info *> zone) {
+static void save_zone(saver *s, ship_space *ship, topo_info *t, zone_info const &z) {
     glm::ivec3 pos;
-    if (!ship->topo_to_pos(zone.first, &pos))
+    if (!ship->topo_to_pos(t, &pos))
         return; /* not a real zone. this was probably outside. */
 
     auto zone_lump = s->begin_lump(fourcc("ZONE"));
@@ -129,7 +142,7 @@ static void save_zone(saver *s, ship_space *ship, std::pair<topo_info *, zone_in
     s->write(pos.z);
 
     for (int i = 0; i < int(gas::upper_bound); i++) {
-        s->write(zone.second->gas_amount[i]);
+        s->write(z.gas_amount[i]);
     }
 
     s->end_lump(zone_lump);
@@ -140,9 +153,9 @@ static void save_ship(saver *s, ship_space *ship) {
     for (auto chunk : ship->chunks) {
         save_chunk(s, chunk);
     }
-    for (auto zone : ship->zones) {
-        save_zone(s, ship, zone);
-    }
+    ship->for_each_zone([&](topo_info *t, zone_info &z) {
+        save_zone(s, ship, t, z);
+    });
     s->end_lump(ship_lump);
 }
 
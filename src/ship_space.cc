@@ -1,51 +1,40 @@
 #include "ship_space.h"
+#include "block_cursor.h"
+#include "parallel.h"
 #include <assert.h>
 #include <math.h>
+#include <algorithm>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
 
 
+/* where every ship's topo_epoch comes from */
+static unsigned last_topo_epoch;
+
 /* create an empty ship_space */
 ship_space::ship_space(void)
     : mins(), maxs(),
-      num_full_rebuilds(0), num_fast_unifys(0), num_fast_nosplits(0), num_false_splits(0)
-{
-}
-
-
-static void
-split_coord(int p, int *out_block, int *out_chunk)
+      outside_zone(0), topo_epoch(++last_topo_epoch), edit_depth(0), num_dead_roots(0),
+      num_full_rebuilds(0), num_fast_unifys(0), num_fast_nosplits(0), num_false_splits(0),
+      num_fast_splits(0), num_split_visits(0)
 {
-    /* NOTE: There are a number of attractive-looking symmetries which are
-     * just plain wrong. */
-    int block, chunk;
-
-    if (p < 0) {
-        /* negative space is not a mirror of positive:
-         * chunk -1 spans blocks -8..-1;
-         * chunk -2 spans blocks -16..-9 */
-        chunk = (p - CHUNK_SIZE + 1) / CHUNK_SIZE;
-    } else {
-        /* positive halfspace has no rocket science. */
-        chunk = p / CHUNK_SIZE;
-    }
-
-    /* the within-chunk offset is just the difference between the minimum block
-     * in the chunk and the requested one, regardless of which halfspace we're in. */
-    block = p - CHUNK_SIZE * chunk;
+    outside_topo_info.p = &outside_topo_info;
+    outside_topo_info.rank = 0;
+    outside_topo_info.size = 0;
 
-    /* write the outputs which were requested */
-    if (out_block)
-        *out_block = block;
-    if (out_chunk)
-        *out_chunk = chunk;
+    /* id 0 is no zone */
+    zone_data.resize(1);
+    zone_root.resize(1);
 }
 
 
-/* returns a block or null
+/* returns a block, which is null if there is no chunk there
  * finds the block at the position (x,y,z) within
  * the whole ship_space
  * will move across chunks
  */
-block *
+block
 ship_space::get_block(glm::ivec3 block)
 {
     /* Within Block coordinates */
@@ -59,10 +48,50 @@ ship_space::get_block(glm::ivec3 block)
     chunk *c = this->get_chunk(ch);
 
     if( ! c ){
-        return 0;
+        return {};
     }
 
-    return c->blocks.get(wb_x, wb_y, wb_z);
+    /* the caller may write through this */
+    expand_chunk(c);
+
+    return c->get_block(wb_x, wb_y, wb_z);
+}
+
+/* as get_block, but only for reading; never expands a uniform chunk */
+const_block
+ship_space::peek_block(glm::ivec3 block)
+{
+    /* Within Block coordinates */
+    int wb_x, wb_y, wb_z;
+    glm::ivec3 ch;
+
+    split_coord(block.x, &wb_x, &ch.x);
+    split_coord(block.y, &wb_y, &ch.y);
+    split_coord(block.z, &wb_z, &ch.z);
+
+    chunk *c = this->get_chunk(ch);
+
+    if (!c) {
+        return {};
+    }
+
+    return c->peek_block(wb_x, wb_y, wb_z);
+}
+
+void
+ship_space::expand_chunk(chunk *ch)
+{
+    if (ch->is_uniform()) {
+        /* the chunk's node stops standing for its blocks; a root which
+         * relied on it to find a position takes block 0 instead */
+        topo_info *root = topo_find(&ch->uniform_topo);
+        topo_root *r = root_storage.owner_of(root);
+        ch->expand(block_storage.alloc());
+        ch->blocks->cell_topo(0)->p = root;
+        if (r && r->rep == &ch->uniform_topo) {
+            r->rep = ch->blocks->cell_topo(0);
+        }
+    }
 }
 
 /* returns a topo_info or null
@@ -87,17 +116,76 @@ ship_space::get_topo_info(glm::ivec3 block)
         return &this->outside_topo_info;
     }
 
-    return c->topo.get(wb_x, wb_y, wb_z);
+    return c->get_topo(wb_x, wb_y, wb_z);
+}
+
+/* where root t keeps its zone id */
+unsigned &
+ship_space::zone_id(topo_info *t)
+{
+    if (t == &outside_topo_info) {
+        return outside_zone;
+    }
+
+    /* every other root is a topo_root's node */
+    assert(t->p == t && root_storage.owner_of(t) == (topo_root *)t);
+    return ((topo_root *)t)->zone;
 }
 
 zone_info *
 ship_space::get_zone_info(topo_info *t)
 {
-    auto it = zones.find(t);
-    if (it == zones.end())
-        return nullptr;
+    unsigned id = zone_id(t);
+    return id ? &zone_data[id] : nullptr;
+}
+
+zone_info *
+ship_space::ensure_zone(topo_info *t)
+{
+    unsigned &id = zone_id(t);
+    if (!id) {
+        if (free_zones.empty()) {
+            id = (unsigned)zone_data.size();
+            zone_data.emplace_back();
+            zone_root.push_back(t);
+        }
+        else {
+            id = free_zones.back();
+            free_zones.pop_back();
+            zone_data[id] = {};
+            zone_root[id] = t;
+        }
+
+        bump_topo_epoch();
+    }
+
+    return &zone_data[id];
+}
+
+void
+ship_space::bump_topo_epoch()
+{
+    topo_epoch = ++last_topo_epoch;
+}
 
-    return it->second;
+unsigned
+ship_space::cached_zone(glm::ivec3 b, glm::ivec3 *block, unsigned *epoch, unsigned *zone)
+{
+    if (*epoch != topo_epoch || b != *block) {
+        *block = b;
+        *epoch = topo_epoch;
+        *zone = zone_id(topo_find(get_topo_info(b)));
+    }
+
+    return *zone;
+}
+
+/* give up zone id. the root which held it must already have forgotten it */
+void
+ship_space::free_zone(unsigned id)
+{
+    zone_root[id] = nullptr;
+    free_zones.push_back(id);
 }
 
 /* returns the chunk containing the block denotated by (x, y, z)
@@ -121,12 +209,15 @@ ship_space::get_chunk_containing(glm::ivec3 block)
 chunk *
 ship_space::get_chunk(glm::ivec3 ch)
 {
-    auto it = this->chunks.find(ch);
-    if( it != this->chunks.end() ){
-        return it->second;
-    }
+    return this->chunks.get(ch);
+}
 
-    return nullptr;
+void
+ship_space::get_chunk_neighbours(chunk *ch, chunk *out[face_count])
+{
+    for (int f = 0; f < int(face_count); f++) {
+        out[f] = get_chunk(ch->pos + surface_index_to_normal(f));
+    }
 }
 
 
@@ -143,11 +234,41 @@ max_along_axis(float o, float d)
 }
 
 
+static bool
+is_solid(block_type type)
+{
+    return type != block_empty && type != block_untouched;
+}
+
+/* can a ray stop anywhere in chunk ch (which may be null)?
+ *
+ * a missing or uniform chunk has no surfaces, so only entering or leaving
+ * framing can stop it -- and every block in it is the same, so that
+ * happens right at the boundary or not at all.
+ */
+static bool
+ray_can_stop_in(chunk *ch, bool inside, raycast_stopping_rule stopping_rule)
+{
+    if (!(stopping_rule & enter_exit_framing)) {
+        return ch && !ch->is_uniform();
+    }
+
+    if (!ch) {
+        return inside;
+    }
+
+    return !ch->is_uniform() || inside != is_solid(ch->uniform_type);
+}
+
 bool
 ship_space::raycast_block(glm::vec3 o, glm::vec3 d, float max_reach_distance, raycast_stopping_rule stopping_rule, raycast_info_block *rc)
 {
     /* implementation of the algorithm described in
      * http://www.cse.yorku.ca/~amana/research/grid.pdf
+     *
+     * with a shortcut through chunks the ray can't stop in: those are run
+     * through without looking at any blocks, taking exactly the same steps
+     * so that the result is the same.
      */
 
     assert(rc);
@@ -158,71 +279,90 @@ ship_space::raycast_block(glm::vec3 o, glm::vec3 d, float max_reach_distance, ra
      * as float truncation will bias
      * towards 0
      */
-    int x = (int)(o.x < 0 ? o.x - 1: o.x);
-    int y = (int)(o.y < 0 ? o.y - 1: o.y);
-    int z = (int)(o.z < 0 ? o.z - 1: o.z);
+    glm::ivec3 p((int)(o.x < 0 ? o.x - 1: o.x),
+                 (int)(o.y < 0 ? o.y - 1: o.y),
+                 (int)(o.z < 0 ? o.z - 1: o.z));
 
-    int nx = 0;
-    int ny = 0;
-    int nz = 0;
+    glm::ivec3 n(0);
 
-    block *bl = nullptr;
+    const_block bl;
 
-    bl = this->get_block(glm::ivec3(x,y,z));
-    rc->inside = bl ? bl->type != block_empty && bl->type != block_untouched : false;
+    /* the ray only ever moves one block along one axis at a time, so the
+     * cursor only goes back to the chunk index at chunk boundaries */
+    block_cursor cur(this, p);
+    bl = cur.get();
+    rc->inside = bl ? is_solid(*bl.type) : false;
 
-    int stepX = d.x > 0 ? 1 : -1;
-    int stepY = d.y > 0 ? 1 : -1;
-    int stepZ = d.z > 0 ? 1 : -1;
+    glm::ivec3 step(d.x > 0 ? 1 : -1,
+                    d.y > 0 ? 1 : -1,
+                    d.z > 0 ? 1 : -1);
 
-    float tDeltaX = fabsf(1/d.x);
-    float tDeltaY = fabsf(1/d.y);
-    float tDeltaZ = fabsf(1/d.z);
+    glm::vec3 tDelta(fabsf(1/d.x), fabsf(1/d.y), fabsf(1/d.z));
 
-    float tMaxX = max_along_axis(o.x, d.x);
-    float tMaxY = max_along_axis(o.y, d.y);
-    float tMaxZ = max_along_axis(o.z, d.z);
+    glm::vec3 tMax(max_along_axis(o.x, d.x),
+                   max_along_axis(o.y, d.y),
+                   max_along_axis(o.z, d.z));
     float t = 0;
 
-    while (t < max_reach_distance) {
-        if (tMaxX < tMaxY) {
-            if (tMaxX < tMaxZ) {
-                x += stepX;
-                t = tMaxX;
-                tMaxX += tDeltaX;
-                nx = -stepX;
-                ny = 0;
-                nz = 0;
-            }
-            else {
-                z += stepZ;
-                t = tMaxZ;
-                tMaxZ += tDeltaZ;
-                nx = 0;
-                ny = 0;
-                nz = -stepZ;
-            }
+    /* once outside every chunk, the ray can only stop if it comes back */
+    bool can_stop_outside = ray_can_stop_in(nullptr, rc->inside, stopping_rule);
+
+    /* only worked out again when the ray moves to another chunk */
+    chunk *last_ch = cur.ch;
+    bool can_stop = ray_can_stop_in(cur.ch, rc->inside, stopping_rule);
+
+    auto next_axis = [&]() {
+        if (tMax.x < tMax.y) {
+            return tMax.x < tMax.z ? 0 : 2;
         }
         else {
-            if (tMaxY < tMaxZ) {
-                y += stepY;
-                t = tMaxY;
-                tMaxY += tDeltaY;
-                nx = 0;
-                ny = -stepY;
-                nz = 0;
+            return tMax.y < tMax.z ? 1 : 2;
+        }
+    };
+
+    auto take_step = [&](int axis) {
+        p[axis] += step[axis];
+        cur.step(axis, step[axis]);
+        t = tMax[axis];
+        tMax[axis] += tDelta[axis];
+        n = glm::ivec3(0);
+        n[axis] = -step[axis];
+    };
+
+    while (t < max_reach_distance) {
+        take_step(next_axis());
+
+        if (cur.ch != last_ch) {
+            last_ch = cur.ch;
+            can_stop = ray_can_stop_in(cur.ch, rc->inside, stopping_rule);
+        }
+
+        if (!can_stop) {
+            if (!cur.ch && !can_stop_outside) {
+                /* leaving the ship for good? */
+                for (int axis = 0; axis < 3; axis++) {
+                    if ((cur.chunk_pos[axis] < mins[axis] && !(d[axis] > 0)) ||
+                        (cur.chunk_pos[axis] > maxs[axis] && !(d[axis] < 0))) {
+                        return rc->hit;
+                    }
+                }
             }
-            else {
-                z += stepZ;
-                t = tMaxZ;
-                tMaxZ += tDeltaZ;
-                nx = 0;
-                ny = 0;
-                nz = -stepZ;
+
+            /* run through to the last block before the chunk boundary */
+            while (t < max_reach_distance) {
+                int axis = next_axis();
+                int l = cur.local[axis] + step[axis];
+                if (l < 0 || l >= CHUNK_SIZE) {
+                    break;
+                }
+
+                take_step(axis);
             }
+
+            continue;
         }
 
-        bl = this->get_block(glm::ivec3(x, y, z));
+        bl = cur.get();
         if (!bl && !rc->inside){
             /* if there is no block then we are outside the grid
              * we still want to keep stepping until we either
@@ -233,38 +373,26 @@ ship_space::raycast_block(glm::vec3 o, glm::vec3 d, float max_reach_distance, ra
         }
 
         if (stopping_rule & enter_exit_framing) {
-            if (rc->inside ^ (bl && bl->type != block_empty && bl->type != block_untouched)) {
+            if (rc->inside ^ (bl && is_solid(*bl.type))) {
                 rc->hit = true;
-                rc->bl.x = x;
-                rc->bl.y = y;
-                rc->bl.z = z;
+                rc->bl = p;
                 rc->block = bl;
-                rc->n.x = nx;
-                rc->n.y = ny;
-                rc->n.z = nz;
-                rc->p.x = x + nx;
-                rc->p.y = y + ny;
-                rc->p.z = z + nz;
+                rc->n = n;
+                rc->p = p + n;
                 rc->t = t;
-		        rc->hitCoord = o + rc->t * d;
+                rc->hitCoord = o + rc->t * d;
                 return rc->hit;
             }
         }
 
         if (stopping_rule & cross_surface) {
-            int index = normal_to_surface_index(nx, ny, nz);
-            if (bl && bl->surfs[index]) {
+            int index = normal_to_surface_index(n.x, n.y, n.z);
+            if (bl && bl.surfs[index]) {
                 rc->hit = true;
-                rc->bl.x = x;
-                rc->bl.y = y;
-                rc->bl.z = z;
+                rc->bl = p;
                 rc->block = bl;
-                rc->n.x = nx;
-                rc->n.y = ny;
-                rc->n.z = nz;
-                rc->p.x = x + nx;
-                rc->p.y = y + ny;
-                rc->p.z = z + nz;
+                rc->n = n;
+                rc->p = p + n;
                 rc->t = t;
                 rc->hitCoord = o + rc->t * d;
                 return rc->hit;
@@ -280,7 +408,7 @@ ship_space::raycast_block(glm::vec3 o, glm::vec3 d, float max_reach_distance, ra
  *
  * this will not instantiate or modify any other chunks
  */
-block *
+block
 ship_space::ensure_block(glm::ivec3 block)
 {
     glm::ivec3 ch;
@@ -303,21 +431,17 @@ ship_space::ensure_block(glm::ivec3 block)
  * changes.
  */
 static chunk *
-create_chunk(ship_space *ship)
+create_chunk(ship_space *ship, glm::ivec3 pos)
 {
-    auto *ch = new chunk();
+    auto *ch = ship->chunk_storage.alloc();
+    ch->pos = pos;
 
-    /* All the topo nodes in the new chunk should be attached
-     * to the outside node.
+    /* The new chunk is uniformly untouched, so its one topo node stands
+     * for all its blocks; attach that to the outside node.
      */
-    for (auto k = 0; k < CHUNK_SIZE; k++) {
-        for (auto j = 0; j < CHUNK_SIZE; j++) {
-            for (auto i = 0; i < CHUNK_SIZE; i++) {
-                topo_info *t = ch->topo.get(i, j, k);
-                t->p = &ship->outside_topo_info;
-            }
-        }
-    }
+    ch->uniform_topo.p = &ship->outside_topo_info;
+    ch->uniform_topo.rank = 0;
+    ch->uniform_topo.size = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
 
     /* Adjust the size of the outside chunk. This is currently not
      * used for anything, but the consistency is nice and the cost is negligible.
@@ -326,33 +450,118 @@ create_chunk(ship_space *ship)
     return ch;
 }
 
+/* is there any chunk beyond chunk v, looking along axis in direction dir? */
+bool
+ship_space::has_chunk_along(glm::ivec3 v, int axis, int dir)
+{
+    glm::ivec3 key = v;
+    key[axis] = 0;
+
+    auto line = chunk_lines[axis].find(key);
+    if (line == chunk_lines[axis].end()) {
+        return false;
+    }
+
+    if (dir > 0) {
+        return line->second.upper_bound(v[axis]) != line->second.end();
+    }
+    else {
+        return line->second.lower_bound(v[axis]) != line->second.begin();
+    }
+}
+
+/* could missing chunk v be enclosed by the ship?
+ *
+ * anything enclosed is walled in by surfaces, and every surface lives in a
+ * chunk that exists -- so a straight line from an enclosed chunk in any
+ * direction must run into some chunk. conversely, if a line in some
+ * direction runs into nothing at all, it is a path of pure vacuum out of
+ * the ship, and v may as well be left missing (ie, outside).
+ */
+bool
+ship_space::possibly_enclosed(glm::ivec3 v)
+{
+    for (int axis = 0; axis < 3; axis++) {
+        if (!has_chunk_along(v, axis, 1) || !has_chunk_along(v, axis, -1)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* record chunk v in the three axis lines through it */
+void
+ship_space::add_to_chunk_lines(glm::ivec3 v)
+{
+    for (int axis = 0; axis < 3; axis++) {
+        glm::ivec3 key = v;
+        key[axis] = 0;
+        chunk_lines[axis][key].insert(v[axis]);
+    }
+}
+
+/* chunk v was just created. create any missing chunks which might now be
+ * enclosed, so the atmo system sees their air as part of whatever encloses
+ * them rather than as open vacuum.
+ *
+ * the only candidates are the missing chunks in line with v, between v and
+ * the next chunk along: nothing else gained a chunk in any direction. any
+ * chunk we create is itself a new chunk, so gets the same treatment.
+ */
+void
+ship_space::enclose_around(glm::ivec3 v)
+{
+    std::vector<glm::ivec3> work;
+    add_to_chunk_lines(v);
+    work.push_back(v);
+
+    while (!work.empty()) {
+        glm::ivec3 c = work.back();
+        work.pop_back();
+
+        for (int axis = 0; axis < 3; axis++) {
+            glm::ivec3 key = c;
+            key[axis] = 0;
+            auto &line = chunk_lines[axis][key];
+            auto it = line.find(c[axis]);
+
+            int lo = it == line.begin() ? c[axis] : *std::prev(it);
+            int hi = std::next(it) == line.end() ? c[axis] : *std::next(it);
+
+            for (int p = lo + 1; p < hi; p++) {
+                glm::ivec3 other = c;
+                other[axis] = p;
+
+                if (chunks.get(other) || !possibly_enclosed(other)) {
+                    continue;
+                }
+
+                chunks.set(other, create_chunk(this, other));
+                add_to_chunk_lines(other);
+                work.push_back(other);
+            }
+        }
+    }
+}
+
 /* ensure that the specified chunk exists
  *
- * this will instantiate a new chunk if necessary -- any other possibly-enclosed
- * missing chunks to unconfuse the atmo system.
+ * this will instantiate a new chunk if necessary -- and any other missing
+ * chunks which that might enclose, to unconfuse the atmo system.
  */
 chunk *
 ship_space::ensure_chunk(glm::ivec3 v)
 {
-    /* automatically creates the entry if not present */
-    auto &ch = this->chunks[v];
+    auto ch = this->chunks.get(v);
     if (!ch) {
         this->mins = glm::min(this->mins, v);
         this->maxs = glm::max(this->maxs, v);
 
-        ch = create_chunk(this);
+        ch = create_chunk(this, v);
+        this->chunks.set(v, ch);
 
-        /* ensure any other missing possibly-enclosed chunks exist too */
-        for (auto k = this->mins.z + 1; k < this->maxs.z; k++) {
-            for (auto j = this->mins.y + 1; j < this->maxs.y; j++) {
-                for (auto i = this->mins.x + 1; i < this->maxs.x; i++) {
-                    auto &other_ch = this->chunks[glm::ivec3(i, j, k)];
-                    if (!other_ch) {
-                        other_ch = create_chunk(this);
-                    }
-                }
-            }
-        }
+        enclose_around(v);
     }
 
     return ch;
@@ -393,28 +602,137 @@ topo_unite(topo_info *from, topo_info *to)
     }
 }
 
-/* inserts a zone_info into the zone map. z may be
- * deleted, if there is an existing zone to merge into. */
+/* adds z's gas to t's zone, making one if there isn't one yet */
 void
-ship_space::insert_zone(topo_info *t, zone_info *z)
+ship_space::insert_zone(topo_info *t, zone_info const &z)
 {
-    if (t == &outside_topo_info) {
+    if (t == topo_find(&outside_topo_info)) {
         /* there is no point in combining with the outside. */
-        delete z;
         return;
     }
 
-    zone_info *existing_z = get_zone_info(t);
-    if (existing_z) {
-        /* merge case; mix in this zone, and then we'll delete it. */
+    zone_info *existing_z = ensure_zone(t);
+    for (int i = 0; i < int(gas::upper_bound); i++) {
+        existing_z->gas_amount[i] += z.gas_amount[i];
+    }
+}
+
+/* hand zone id, whose root has just been united into root, over to it:
+ * mixed into root's own zone if it has one, and given up altogether if
+ * root is the outside. the outside node isn't always its own root -- a
+ * union may have hung it under another -- so that is what to compare. */
+static void
+attach_zone(ship_space *ship, topo_info *root, unsigned id)
+{
+    if (root == topo_find(&ship->outside_topo_info)) {
+        ship->free_zone(id);
+        return;
+    }
+
+    unsigned &existing = ship->zone_id(root);
+    if (existing && existing != id) {
+        zone_info &into = ship->zone_data[existing];
+        zone_info const &from = ship->zone_data[id];
         for (int i = 0; i < int(gas::upper_bound); i++) {
-            existing_z->gas_amount[i] += z->gas_amount[i];
+            into.gas_amount[i] += from.gas_amount[i];
         }
-        delete z;
+        ship->free_zone(id);
     }
     else {
-        /* no zone here yet. this one will do fine! */
-        zones[t] = z;
+        existing = id;
+        ship->zone_root[id] = root;
+    }
+}
+
+/* the pressure at p, as sensors and the debug readout take it -- its
+ * zone's oxygen -- and in field mode, how far p is from that while the
+ * zone is still mixing */
+float
+ship_space::pressure_at(glm::ivec3 p)
+{
+    topo_info *t = topo_find(get_topo_info(p));
+    zone_info *z = get_zone_info(t);
+    float pressure = z ? z->gas_amount[int(gas::oxygen)] / t->size : 0.0f;
+
+    return std::max(0.0f, pressure + field.deviation(this, p));
+}
+
+void
+ship_space::add_opening(glm::ivec3 p, int face, float width)
+{
+    if (width > 0) {
+        openings.push_back(opening{p, face, width});
+    }
+}
+
+/* blocks' worth of gas a second through one block of fully open face, for
+ * a difference in pressure of one */
+static float const opening_flow_rate = 4.0f;
+
+void
+ship_space::tick_gas_flow(float dt)
+{
+    topo_info *outside = topo_find(&outside_topo_info);
+    std::unordered_map<topo_info *, unsigned> index;
+
+    /* number the zones on either side of an opening, the outside first */
+    flow.clear();
+    index[outside] = flow.add_zone(outside, 0, nullptr);
+
+    auto zone_index = [&](topo_info *t) {
+        auto it = index.insert(std::make_pair(t, flow.num_zones()));
+        if (it.second) {
+            zone_info *z = get_zone_info(t);
+            flow.add_zone(t, float(t->size), z ? z->gas_amount : nullptr);
+        }
+        return it.first->second;
+    };
+
+    for (auto const &o : openings) {
+        /* with the surface gone, the zones have been joined anyway */
+        const_block bl = peek_block(o.p);
+        if (!bl || air_permeable(bl.surfs[o.face])) {
+            continue;
+        }
+
+        glm::ivec3 q = o.p + surface_index_to_normal((surface_index)o.face);
+        topo_info *t = topo_find(get_topo_info(o.p));
+        topo_info *u = topo_find(get_topo_info(q));
+        if (t != u) {
+            flow.add_edge(zone_index(t), zone_index(u), o.width * opening_flow_rate);
+        }
+    }
+
+    if (flow.num_edges()) {
+        flow.step(dt);
+
+        for (unsigned i = 1; i < flow.num_zones(); i++) {
+            topo_info *t = flow.zone_topo[i];
+            zone_info *z = get_zone_info(t);
+            if (!z) {
+                /* only make a zone for gas which has flowed in */
+                bool any = false;
+                for (int g = 0; g < int(gas::upper_bound); g++) {
+                    any = any || flow.amount[g][i] > 0;
+                }
+                if (!any) {
+                    continue;
+                }
+
+                z = ensure_zone(t);
+            }
+
+            for (int g = 0; g < int(gas::upper_bound); g++) {
+                z->gas_amount[g] = flow.amount[g][i];
+            }
+        }
+    }
+
+    /* remove any air that someone managed to get into the outside. try as
+     * hard as you like, you cannot fill space with your air system */
+    zone_info *z = get_zone_info(outside);
+    if (z) {
+        *z = {};
     }
 }
 
@@ -431,57 +749,61 @@ ship_space::update_topology_for_remove_surface(glm::ivec3 a, glm::ivec3 b)
         return;
     }
 
-    zone_info *z1 = get_zone_info(t);
-    zone_info *z2 = get_zone_info(u);
+    unsigned z1 = zone_id(t);
+    unsigned z2 = zone_id(u);
+
+    if (field.enabled) {
+        /* each side starts off at the pressure it had -- its oxygen, as
+         * sensors read it -- and the difference from the merged zone's
+         * then spreads out. the outside is already at its own pressure,
+         * which is none. */
+        topo_info *outside = topo_find(&outside_topo_info);
+        float gt = z1 ? zone_data[z1].gas_amount[int(gas::oxygen)] : 0.0f;
+        float gu = z2 ? zone_data[z2].gas_amount[int(gas::oxygen)] : 0.0f;
+
+        float pv = (t == outside || u == outside) ? 0.0f : (gt + gu) / (t->size + u->size);
+        if (t != outside) {
+            field.seed(this, a, gt / t->size - pv);
+        }
+        if (u != outside) {
+            field.seed(this, b, gu / u->size - pv);
+        }
+    }
 
-    /* remove the existing zones */
-    if (z1) { zones.erase(zones.find(t)); }
-    if (z2) { zones.erase(zones.find(u)); }
+    /* take the zones off their old roots */
+    zone_id(t) = 0;
+    zone_id(u) = 0;
 
     topo_info *v = topo_unite(t, u);
     /* track sizing */
     v->size = t->size + u->size;
+    bump_topo_epoch();
 
-    /* reinsert both zones at v */
-    if (z1) { insert_zone(v, z1); }
-    if (z2) { insert_zone(v, z2); }
-}
-
-static bool
-exists_alt_path(int x, int y, int z, block *a, block *b, ship_space *ship, int face)
-{
-    block *c;
+    /* and put both on v */
+    if (z1) { attach_zone(this, v, z1); }
+    if (z2) { attach_zone(this, v, z2); }
 
-    if (face != surface_xp) {
-        c = ship->get_block(glm::ivec3(x+1, y, z));
-        if (air_permeable(a->surfs[surface_xp]) && air_permeable(b->surfs[surface_xp]) &&
-                (!c || air_permeable(c->surfs[face])))
-            return true;
-        c = ship->get_block(glm::ivec3(x-1, y, z));
-        if (air_permeable(a->surfs[surface_xm]) && air_permeable(b->surfs[surface_xm]) &&
-                (!c || air_permeable(c->surfs[face])))
-            return true;
+    /* the other has been merged away, unless it was the outside */
+    if ((v == t ? u : t) != &outside_topo_info) {
+        num_dead_roots++;
     }
 
-    if (face != surface_yp) {
-        c = ship->get_block(glm::ivec3(x, y+1, z));
-        if (air_permeable(a->surfs[surface_yp]) && air_permeable(b->surfs[surface_yp]) &&
-                (!c || air_permeable(c->surfs[face])))
-            return true;
-        c = ship->get_block(glm::ivec3(x, y-1, z));
-        if (air_permeable(a->surfs[surface_ym]) && air_permeable(b->surfs[surface_ym]) &&
-                (!c || air_permeable(c->surfs[face])))
-            return true;
+    if (num_dead_roots > std::max<int>(64, (int)chunks.size())) {
+        free_dead_roots();
     }
+}
 
-    if (face != surface_zp) {
-        c = ship->get_block(glm::ivec3(x, y, z+1));
-        if (air_permeable(a->surfs[surface_zp]) && air_permeable(b->surfs[surface_zp]) &&
-                (!c || air_permeable(c->surfs[face])))
-            return true;
-        c = ship->get_block(glm::ivec3(x, y, z-1));
-        if (air_permeable(a->surfs[surface_zm]) && air_permeable(b->surfs[surface_zm]) &&
-                (!c || air_permeable(c->surfs[face])))
+static bool
+exists_alt_path(block_cursor const &at, const_block a, const_block b, int face)
+{
+    for (int alt = 0; alt < 6; alt++) {
+        /* only paths around the new surface, not through it */
+        if ((alt >> 1) == (face >> 1))
+            continue;
+
+        const_block c = at.neighbor(alt).get();
+        if (air_permeable(a.surfs[alt]) && air_permeable(b.surfs[alt]) &&
+                (!c || air_permeable(c.surfs[face])))
             return true;
     }
 
@@ -492,59 +814,179 @@ exists_alt_path(int x, int y, int z, block *a, block *b, ship_space *ship, int f
 void
 ship_space::update_topology_for_add_surface(glm::ivec3 a, glm::ivec3 b, int face)
 {
-    /* can this surface even split (does it block atmo?) */
-    if (air_permeable(get_block(a)->surfs[face]))
+    pending_splits.push_back(pending_split{a, b, face});
+
+    if (!edit_depth) {
+        apply_pending_splits();
+    }
+}
+
+/* ch's surfaces have changed; label its cells again. each new cell joins
+ * the component its blocks were in -- removing a surface unites the
+ * components on either side straight away, and adding one only splits
+ * them afterwards, so the blocks of a cell always agree.
+ */
+void
+ship_space::update_cells(chunk *ch)
+{
+    if (ch->is_uniform()) {
         return;
+    }
+
+    chunk_blocks *bl = ch->blocks;
+    unsigned short *cell = &bl->cells.contents[0][0][0];
+    std::vector<unsigned short> old_cell(cell, cell + CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE);
+
+    bl->find_cells();
+
+    for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE; i++) {
+        if (cell[i] == i) {
+            /* a node rewritten here already led to this same root */
+            topo_info *t = bl->cell_topo(i);
+            t->p = topo_find(bl->cell_topo(old_cell[i]));
+            t->rank = 0;
+        }
+    }
+
+    /* a root which found its position through a head which is no more
+     * takes the head of that block's cell now */
+    for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE; i++) {
+        if (old_cell[i] == i && cell[i] != i) {
+            topo_root *r = root_storage.owner_of(topo_find(bl->cell_topo(cell[i])));
+            if (r && r->rep == bl->cell_topo(i)) {
+                r->rep = bl->cell_topo(cell[i]);
+            }
+        }
+    }
+}
+
+/* ch's cells need labelling again, now or at commit if inside a batch */
+void
+ship_space::mark_cells_dirty(chunk *ch)
+{
+    if (edit_depth) {
+        cells_dirty.insert(ch);
+    }
+    else {
+        update_cells(ch);
+    }
+}
+
+/* could surface s still divide space? */
+bool
+ship_space::may_split(pending_split const &s)
+{
+    glm::ivec3 a = s.a;
+    int face = s.face;
+
+    /* can this surface even split (does it block atmo?). inside a batch, it
+     * may have been removed again since. */
+    if (air_permeable(peek_block(a).surfs[face]))
+        return false;
 
     /* collapse an obvious symmetry */
     if (face & 1) {
         /* symmetry */
-        std::swap(a, b);
+        a = s.b;
         face ^= 1;
     }
 
     /* try to quickly prove that we don't divide space */
-    if (exists_alt_path(a.x, a.y, a.z, get_block(a), get_block(b), this, face)) {
+    block_cursor at(this, a);
+    if (exists_alt_path(at, at.get(), at.neighbor(face).get(), face)) {
         num_fast_nosplits++;
+        return false;
+    }
+
+    return true;
+}
+
+void
+ship_space::apply_pending_splits()
+{
+    std::vector<pending_split> splits;
+    for (auto &s : pending_splits) {
+        if (may_split(s)) {
+            splits.push_back(s);
+        }
+    }
+    pending_splits.clear();
+
+    if (!splits.empty()) {
+        split_topology(splits);
+    }
+}
+
+void
+ship_space::begin_edit()
+{
+    edit_depth++;
+}
+
+void
+ship_space::commit_edit()
+{
+    assert(edit_depth > 0);
+
+    if (--edit_depth) {
         return;
     }
 
-    /* grab our air amount data before rebuild_topology invalidates the existing zones */
-    zone_info zone_data{};
-    zone_info *zone = get_zone_info(topo_find(get_topo_info(a)));
-    if (zone)
-        zone_data = *zone;
+    for (auto ch : edit_dirty) {
+        ch->dirty();
+    }
+    edit_dirty.clear();
 
-    /* we do need to split */
-    rebuild_topology();
+    /* the splits are found by cells, so those go first */
+    for (auto ch : cells_dirty) {
+        update_cells(ch);
+    }
+    cells_dirty.clear();
 
-    topo_info *t1 = topo_find(get_topo_info(a));
-    topo_info *t2 = topo_find(get_topo_info(b));
-    if (t1 == t2) {
-        /* we blew it. we didn't actually split the space, but we did
-         * all the work anyway. this is mostly interesting if you're
-         * tweaking exists_alt_path. */
-        num_false_splits++;
+    apply_pending_splits();
+    pop_stripped_attachments();
+}
+
+/* pop whatever the batch left attached to a surface it took away */
+void
+ship_space::pop_stripped_attachments()
+{
+    std::vector<surface_attachment_ref> refs;
+    for (auto c : stripped_chunks) {
+        entities_attached_in_chunk(c, refs);
     }
-    else if (zone) {
-        /* at least one side was real before this split */
+    stripped_chunks.clear();
 
-        /* fixup the zones for the split. we want to maintain the same pressure
-         * we had on both sides, so distribute the mass */
-        zone_info *z1 = get_zone_info(t1);
-        if (!z1) {
-            z1 = zones[t1] = new zone_info{};
+    /* popping may destroy and respawn entities, which only changes the
+     * index, not the list taken here */
+    for (auto &r : refs) {
+        if (!peek_block(r.block).surfs[r.face]) {
+            remove_ents_from_surface(r.block, r.face);
         }
+    }
+}
 
-        zone_info *z2 = get_zone_info(t2);
-        if (!z2) {
-            z2 = zones[t2] = new zone_info{};
-        }
+void
+ship_space::mark_dirty(chunk *ch)
+{
+    if (edit_depth) {
+        edit_dirty.insert(ch);
+    }
+    else {
+        ch->dirty();
+    }
+}
 
-        auto frac = float(t1->size) / (t1->size + t2->size);
-        for (int i = 0; i < int(gas::upper_bound); i++) {
-            z1->gas_amount[i] = zone_data.gas_amount[i] * frac;
-            z2->gas_amount[i] = zone_data.gas_amount[i] - z1->gas_amount[i];
+void
+ship_space::mark_block_dirty(glm::ivec3 p)
+{
+    chunk *ch = get_chunk_containing(p);
+    mark_dirty(ch);
+
+    for (int f = 0; f < int(face_count); f++) {
+        chunk *other = get_chunk_containing(p + surface_index_to_normal(f));
+        if (other && other != ch) {
+            mark_dirty(other);
         }
     }
 }
@@ -559,139 +1001,623 @@ static glm::ivec3 dirs[] = {
 };
 
 
+topo_info *
+ship_space::new_topo_root(topo_info *rep)
+{
+    topo_root *r = root_storage.alloc();
+    r->node.p = &r->node;
+    r->node.rank = 0;
+    r->node.size = 0;
+    r->rep = rep;
+    r->zone = 0;
+    topo_roots.push_back(r);
+    return &r->node;
+}
+
+/* give back the roots which unifys have merged away. nodes may still lead
+ * through them, so every node is first pointed straight at its live root.
+ * that walks every chunk, so is only done once there are more dead roots
+ * than chunks: a few nodes a unify, and the roots kept in step with the
+ * size of the ship rather than with how long it has been edited for. */
+void
+ship_space::free_dead_roots()
+{
+    for (auto c : chunks) {
+        chunk *ch = c.second;
+        topo_find(&ch->uniform_topo);
+
+        if (!ch->is_uniform()) {
+            chunk_blocks *bl = ch->blocks;
+            unsigned short *cell = &bl->cells.contents[0][0][0];
+            for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE; i++) {
+                if (cell[i] == i) {
+                    topo_find(bl->cell_topo(i));
+                }
+            }
+        }
+    }
+
+    topo_find(&outside_topo_info);
+
+    size_t kept = 0;
+    for (auto r : topo_roots) {
+        if (r->node.p == &r->node) {
+            topo_roots[kept++] = r;
+        }
+        else {
+            root_storage.free(r);
+        }
+    }
+    topo_roots.resize(kept);
+    num_dead_roots = 0;
+}
+
+/* call f(p) for a block p across each way out of the node t of chunk ch:
+ * the blocks of a cell on the chunk's faces which let air out, or for a
+ * uniform chunk, everything across its boundary. a uniform (or missing)
+ * neighbour is one node, so only one block of it is given. */
+template<typename F>
+static void
+for_each_way_out(ship_space *ship, chunk *ch, topo_info *t, F const &f)
+{
+    glm::ivec3 base = ch->pos * CHUNK_SIZE;
+
+    if (!ch->is_uniform()) {
+        chunk_blocks *bl = ch->blocks;
+        auto head = (unsigned short)(t - bl->cell_topo(0));
+
+        for (int i = 0; i < 6; i++) {
+            int axis = i >> 1;
+            int face_coord = (i & 1) ? 0 : CHUNK_SIZE - 1;
+            for (int v = 0; v < CHUNK_SIZE; v++) {
+                for (int u = 0; u < CHUNK_SIZE; u++) {
+                    glm::ivec3 p;
+                    p[axis] = face_coord;
+                    p[(axis + 1) % 3] = u;
+                    p[(axis + 2) % 3] = v;
+
+                    if (*bl->cells.get(p.x, p.y, p.z) == head &&
+                            air_permeable((*bl->surfs.get(p.x, p.y, p.z))[i])) {
+                        f(base + p + dirs[i]);
+                    }
+                }
+            }
+        }
+        return;
+    }
+
+    /* no surfaces, so everything across the chunk's boundary */
+    for (int i = 0; i < 6; i++) {
+        glm::ivec3 c = ch->pos + dirs[i];
+        chunk *other = ship->get_chunk(c);
+        if (!other || other->is_uniform()) {
+            f(c * CHUNK_SIZE);
+            continue;
+        }
+
+        int axis = i >> 1;
+        int face_coord = (i & 1) ? CHUNK_SIZE - 1 : 0;
+        for (int v = 0; v < CHUNK_SIZE; v++) {
+            for (int u = 0; u < CHUNK_SIZE; u++) {
+                glm::ivec3 p;
+                p[axis] = face_coord;
+                p[(axis + 1) % 3] = u;
+                p[(axis + 2) % 3] = v;
+                f(c * CHUNK_SIZE + p);
+            }
+        }
+    }
+}
+
+void
+ship_space::component_nodes(glm::ivec3 p, std::vector<component_node> &out)
+{
+    std::unordered_set<topo_info *> seen;
+    size_t next = out.size();
+
+    auto visit = [&](glm::ivec3 b) {
+        glm::ivec3 c, l;
+        split_coord(b.x, &l.x, &c.x);
+        split_coord(b.y, &l.y, &c.y);
+        split_coord(b.z, &l.z, &c.z);
+
+        chunk *ch = get_chunk(c);
+        if (!ch) {
+            return;
+        }
+
+        topo_info *t = ch->get_topo(l.x, l.y, l.z);
+        if (seen.insert(t).second) {
+            out.push_back(component_node{ch, t});
+        }
+    };
+
+    visit(p);
+    while (next < out.size()) {
+        component_node n = out[next++];
+        for_each_way_out(this, n.ch, n.t, visit);
+    }
+}
+
+/* the surfaces in splits may have cut space apart. flood out from both
+ * sides of every one of them at once, a node at a time each; fills which
+ * meet become one. a fill which runs out of space to fill holds exactly a
+ * piece which was cut off. once each old component has at most one fill
+ * still going, every piece which ran out is relabelled and the rest of
+ * the component stays as it was -- so the work is in the size of the
+ * smaller pieces, however big the rest of the ship is.
+ *
+ * the nodes filled are those topo_info can tell apart: the cells of
+ * expanded chunks, whole uniform chunks, and the outside. a cell is all one
+ * within its chunk, so a fill only has to look for the ways out through
+ * the chunk's faces, and relabelling a piece touches one node per cell
+ * rather than per block. the outside can't be filled, so a fill which
+ * reaches it never runs out; all fills which reach it meet there.
+ */
+void
+ship_space::split_topology(std::vector<pending_split> const &splits)
+{
+    struct fill_node {
+        topo_info *t;
+        chunk *ch;
+        glm::ivec3 pos;     /* chunk coords, or the block if there's no chunk */
+    };
+
+    struct fill {
+        topo_info *old_root;
+        std::vector<fill_node> nodes;
+        size_t next = 0;    /* nodes before this have been expanded */
+        int size = 0;       /* in blocks */
+        bool open = false;  /* reached the outside */
+        int merged = -1;    /* the fill this one became part of */
+        bool going = false; /* listed in live, and counted in going */
+
+        bool done() const { return !open && next == nodes.size(); }
+    };
+
+    std::vector<fill> fills;
+    std::unordered_map<topo_info *, int> seen;
+    int open_fill = -1;
+
+    /* the fills not yet merged or run out, and how many of those each old
+     * component has. kept up to date as fills change, rather than found
+     * again every round. */
+    std::vector<int> live;
+    std::unordered_map<topo_info *, int> going;
+
+    auto track = [&](int f) {
+        bool now = fills[f].merged < 0 && !fills[f].done();
+        if (now != fills[f].going) {
+            fills[f].going = now;
+            going[fills[f].old_root] += now ? 1 : -1;
+            if (now) {
+                live.push_back(f);
+            }
+        }
+    };
+
+    auto find_fill = [&](int f) {
+        while (fills[f].merged >= 0) {
+            f = fills[f].merged;
+        }
+        return f;
+    };
+
+    /* fills a and b met; the smaller joins the bigger */
+    auto merge = [&](int a, int b) {
+        if (fills[a].nodes.size() < fills[b].nodes.size()) {
+            std::swap(a, b);
+        }
+
+        /* keep the expanded nodes ahead of those still to do */
+        fill &into = fills[a], &from = fills[b];
+        std::vector<fill_node> nodes;
+        nodes.reserve(into.nodes.size() + from.nodes.size());
+        nodes.insert(nodes.end(), into.nodes.begin(), into.nodes.begin() + into.next);
+        nodes.insert(nodes.end(), from.nodes.begin(), from.nodes.begin() + from.next);
+        nodes.insert(nodes.end(), into.nodes.begin() + into.next, into.nodes.end());
+        nodes.insert(nodes.end(), from.nodes.begin() + from.next, from.nodes.end());
+
+        into.nodes.swap(nodes);
+        into.next += from.next;
+        into.size += from.size;
+        into.open = into.open || from.open;
+        from.merged = a;
+        from.nodes.clear();
+        track(a);
+        track(b);
+        return a;
+    };
+
+    auto node_at = [this](glm::ivec3 p) {
+        glm::ivec3 c, l;
+        split_coord(p.x, &l.x, &c.x);
+        split_coord(p.y, &l.y, &c.y);
+        split_coord(p.z, &l.z, &c.z);
+
+        chunk *ch = get_chunk(c);
+        if (!ch) {
+            return fill_node{&outside_topo_info, nullptr, p};
+        }
+        return fill_node{ch->get_topo(l.x, l.y, l.z), ch, c};
+    };
+
+    auto visit = [&](int f, fill_node n) {
+        f = find_fill(f);
+
+        if (!n.ch) {
+            fills[f].open = true;
+            if (open_fill >= 0 && find_fill(open_fill) != f) {
+                f = merge(f, find_fill(open_fill));
+            }
+            open_fill = f;
+            return;
+        }
+
+        auto it = seen.find(n.t);
+        if (it != seen.end()) {
+            int other = find_fill(it->second);
+            if (other != f) {
+                merge(f, other);
+            }
+            return;
+        }
+
+        seen[n.t] = f;
+        fills[f].nodes.push_back(n);
+        fills[f].size += n.t->size;
+        num_split_visits++;
+    };
+
+    auto expand = [&](int f) {
+        fill_node n = fills[f].nodes[fills[f].next++];
+        for_each_way_out(this, n.ch, n.t, [&](glm::ivec3 p) {
+            visit(f, node_at(p));
+        });
+    };
+
+    for (auto &s : splits) {
+        for (auto p : { s.a, s.b }) {
+            fill_node n = node_at(p);
+            fills.emplace_back();
+            int f = (int)fills.size() - 1;
+            fills[f].old_root = topo_find(n.t);
+            visit(f, n);
+            track(f);
+        }
+    }
+
+    /* fill until no old component has two fills going. fills of different
+     * components never meet, so they can be left to themselves. a fill
+     * which stops going is dropped from live in place, as it is passed. */
+    for (;;) {
+        bool any = false;
+        size_t kept = 0;
+        for (size_t i = 0; i < live.size(); i++) {
+            int f = live[i];
+            if (fills[f].going && !fills[f].open && going[fills[f].old_root] > 1) {
+                expand(f);
+                track(f);
+                any = true;
+            }
+
+            if (fills[f].going) {
+                live[kept++] = f;
+            }
+        }
+        live.resize(kept);
+
+        if (!any) {
+            break;
+        }
+    }
+
+    /* the pieces of each old component */
+    std::unordered_map<topo_info *, std::vector<int>> pieces;
+    for (int f = 0; f < (int)fills.size(); f++) {
+        if (fills[f].merged < 0) {
+            pieces[fills[f].old_root].push_back(f);
+        }
+    }
+
+    bool split_any = false;
+    for (auto &piece : pieces) {
+        topo_info *old_root = piece.first;
+        auto &fs = piece.second;
+        if (fs.size() < 2) {
+            continue;
+        }
+
+        /* the one still going, if any, is the rest of the component and
+         * keeps its root; otherwise the biggest does */
+        int keep = fs[0];
+        for (auto f : fs) {
+            if (!fills[f].done() || (fills[keep].done() && fills[f].size > fills[keep].size)) {
+                keep = f;
+            }
+        }
+
+        /* keep the same pressure in every piece */
+        unsigned z = zone_id(old_root);
+        zone_info old_zone = z ? zone_data[z] : zone_info{};
+        int old_size = old_root->size;
+
+        for (auto f : fs) {
+            if (f == keep) {
+                continue;
+            }
+
+            topo_info *root = new_topo_root(fills[f].nodes[0].t);
+            root->size = fills[f].size;
+            for (auto &n : fills[f].nodes) {
+                n.t->p = root;
+            }
+            old_root->size -= fills[f].size;
+            num_fast_splits++;
+            split_any = true;
+
+            if (z) {
+                auto frac = std::min(1.0f, float(fills[f].size) / old_size);
+                zone_info *pz = ensure_zone(root);
+                for (int i = 0; i < int(gas::upper_bound); i++) {
+                    pz->gas_amount[i] = old_zone.gas_amount[i] * frac;
+                    zone_data[z].gas_amount[i] -= pz->gas_amount[i];
+                }
+            }
+        }
+
+        topo_root *r = root_storage.owner_of(old_root);
+        if (r && seen.count(r->rep) && find_fill(seen[r->rep]) != keep) {
+            r->rep = fills[keep].nodes[0].t;
+        }
+    }
+
+    if (split_any) {
+        bump_topo_epoch();
+    }
+    else {
+        /* every side was still connected to every other. this is mostly
+         * interesting if you're tweaking exists_alt_path. */
+        num_false_splits++;
+    }
+}
+
+/* scratch for one chunk during rebuild_topology */
+struct rebuild_chunk {
+    glm::ivec3 pos;
+    chunk *ch;
+    int band;
+    /* the chunk's nodes: its cells, or the uniform node */
+    std::vector<topo_info *> cells;
+};
+
+/* scratch for one slab of chunks during rebuild_topology */
+struct rebuild_band {
+    std::vector<size_t> chunks;
+    /* stands in for outside_topo_info, which every slab would share */
+    topo_info outside;
+    /* unions with chunks in other slabs, made once the slabs are done */
+    std::vector<std::pair<topo_info *, topo_info *>> deferred;
+};
+
 /* rebuild the ship topology. this is generally not the optimal thing -
  * we can dynamically rebuild parts of the topology cheaper based on
  * knowing the change that was made.
+ *
+ * the work is spread over `threads` threads (0 for one per core). the
+ * components, their sizes and the zones they end up with are the same
+ * however many are used; only which node becomes whose parent differs.
  */
 void
-ship_space::rebuild_topology()
+ship_space::rebuild_topology(unsigned threads)
 {
     num_full_rebuilds++;
 
-    /* 1/ initially, every block is its own subtree */
+    if (!threads) {
+        threads = default_thread_count();
+    }
+
+    std::vector<topo_root *> old_roots;
+    old_roots.swap(topo_roots);
+
+    /* unions across chunk boundaries are made a slab of chunks at a time,
+     * cutting the ship across its longest axis. within a slab, every path
+     * to a root stays within the slab, so slabs don't disturb each other. */
+    std::vector<rebuild_chunk> work;
+    work.reserve(chunks.size());
+    glm::ivec3 lo(0), hi(-1);
     for (auto it = chunks.begin(); it != chunks.end(); it++) {
-        for (int z = 0; z < CHUNK_SIZE; z++) {
-            for (int y = 0; y < CHUNK_SIZE; y++) {
-                for (int x = 0; x < CHUNK_SIZE; x++) {
-                    topo_info *t = it->second->topo.get(x, y, z);
-                    t->p = t;
-                    t->rank = 0;
-                    t->size = 0;
-                }
-            }
+        lo = work.empty() ? it->first : glm::min(lo, it->first);
+        hi = work.empty() ? it->first : glm::max(hi, it->first);
+        work.push_back(rebuild_chunk{it->first, it->second, 0, {}});
+    }
+
+    glm::ivec3 extent = hi - lo + glm::ivec3(1);
+    int band_axis = 0;
+    for (int axis = 1; axis < 3; axis++) {
+        if (extent[axis] > extent[band_axis]) {
+            band_axis = axis;
         }
     }
 
+    /* a few slabs per thread, so that uneven ones balance out */
+    int num_bands = threads == 1 ? 1 : std::max(1, std::min(extent[band_axis], int(threads) * 4));
+    auto band_of = [&](glm::ivec3 c) {
+        return int((long long)(c[band_axis] - lo[band_axis]) * num_bands / extent[band_axis]);
+    };
+
+    std::vector<rebuild_band> bands(num_bands);
+    for (size_t n = 0; n < work.size(); n++) {
+        work[n].band = band_of(work[n].pos);
+        bands[work[n].band].chunks.push_back(n);
+    }
+
     this->outside_topo_info.p = &this->outside_topo_info;
     this->outside_topo_info.rank = 0;
     this->outside_topo_info.size = 0;
 
-    /* 2/ combine across air-permeable interfaces */
-    for (auto it = chunks.begin(); it != chunks.end(); it++) {
-        for (int z = 1; z < CHUNK_SIZE - 1; z++) {
-            for (int y = 1; y < CHUNK_SIZE - 1; y++) {
-                for (int x = 1; x < CHUNK_SIZE - 1; x++) {
-                    block *bl = it->second->blocks.get(x, y, z);
-
-                    for (int i = 0; i < 6; i++) {
-                        if (air_permeable(bl->surfs[i])) {
-                            glm::ivec3 offset = dirs[i];
-                            topo_unite(it->second->topo.get(x, y, z),
-                                       it->second->topo.get(x + offset.x, y + offset.y, z + offset.z));
-                        }
-                    }
-                }
-            }
+    /* 1/ label every chunk's cells; each starts as its own subtree. a
+     * uniform chunk is all one already. this touches nothing outside the
+     * chunk, so chunks are done in parallel. */
+    parallel_for(work.size(), [&](size_t n) {
+        rebuild_chunk &rc = work[n];
+        chunk *ch = rc.ch;
+        topo_info *u = &ch->uniform_topo;
+
+        if (ch->is_uniform()) {
+            u->p = u;
+            u->rank = 0;
+            u->size = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+            rc.cells.push_back(u);
+            return;
         }
 
-        for (int z = 0; z < CHUNK_SIZE; z++) {
-            for (int y = 0; y < CHUNK_SIZE; y++) {
-                block *bl = it->second->blocks.get(0, y, z);
-                topo_info *to = it->second->topo.get(0, y, z);
-
-                for (int i = 0; i < 6; i++) {
-                    if (air_permeable(bl->surfs[i])) {
-                        glm::ivec3 offset = dirs[i];
-                        topo_unite(to,
-                            get_topo_info(CHUNK_SIZE * it->first + glm::ivec3(0, y, z) + offset));
-                    }
-                }
+        chunk_blocks *bl = ch->blocks;
+        bl->find_cells();
 
-                bl = it->second->blocks.get(CHUNK_SIZE - 1, y, z);
-                to = it->second->topo.get(CHUNK_SIZE - 1, y, z);
+        unsigned short *cell = &bl->cells.contents[0][0][0];
+        for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE; i++) {
+            if (cell[i] == i) {
+                topo_info *t = bl->cell_topo(i);
+                t->p = t;
+                t->rank = 0;
+                rc.cells.push_back(t);
+            }
+        }
 
-                for (int i = 0; i < 6; i++) {
-                    if (air_permeable(bl->surfs[i])) {
-                        glm::ivec3 offset = dirs[i];
-                        topo_unite(to,
-                            get_topo_info(CHUNK_SIZE * it->first + glm::ivec3(CHUNK_SIZE - 1, y, z) + offset));
-                    }
-                }
+        /* the uniform node of an expanded chunk no longer stands for
+         * anything by itself; keep it following block 0, so that anything
+         * still pointing at it finds a real component. */
+        u->p = bl->cell_topo(0);
+        u->rank = 0;
+        u->size = 0;
+    }, threads, 64);
+
+    /* the old roots go away at the end; until then, have them follow the
+     * cell their rep's block is in now, so that zones still held by them
+     * find their way */
+    for (auto r : old_roots) {
+        r->node.p = r->rep;
+        if (chunk_blocks *bl = block_storage.owner_of(r->rep)) {
+            unsigned short *cell = &bl->cells.contents[0][0][0];
+            r->node.p = bl->cell_topo(cell[r->rep - bl->cell_topo(0)]);
+        }
+    }
 
-                bl = it->second->blocks.get(y, 0, z);
-                to = it->second->topo.get(y, 0, z);
+    /* 2/ combine across chunk boundaries, each slab in parallel. a union
+     * with another slab is put off until all are done; open vacuum is
+     * the slab's own stand-in, joined to the real thing afterwards. */
+    parallel_for(bands.size(), [&](size_t b) {
+        rebuild_band &band = bands[b];
+        band.outside.p = &band.outside;
+        band.outside.rank = 0;
+        band.outside.size = 0;
+
+        auto join = [&](topo_info *t, glm::ivec3 other_pos, topo_info *o) {
+            if (!o) {
+                topo_unite(t, &band.outside);
+            }
+            else if (band_of(other_pos) != int(b)) {
+                band.deferred.push_back(std::make_pair(t, o));
+            }
+            else {
+                topo_unite(t, o);
+            }
+        };
 
-                for (int i = 0; i < 6; i++) {
-                    if (air_permeable(bl->surfs[i])) {
-                        glm::ivec3 offset = dirs[i];
-                        topo_unite(to,
-                            get_topo_info(CHUNK_SIZE * it->first + glm::ivec3(y, 0, z) + offset));
-                    }
-                }
+        for (auto n : band.chunks) {
+            rebuild_chunk &rc = work[n];
+            chunk *ch = rc.ch;
 
-                bl = it->second->blocks.get(y, CHUNK_SIZE - 1, z);
-                to = it->second->topo.get(y, CHUNK_SIZE - 1, z);
+            for (int i = 0; i < 6; i++) {
+                glm::ivec3 other_pos = rc.pos + dirs[i];
+                chunk *other = get_chunk(other_pos);
 
-                for (int i = 0; i < 6; i++) {
-                    if (air_permeable(bl->surfs[i])) {
-                        glm::ivec3 offset = dirs[i];
-                        topo_unite(to,
-                            get_topo_info(CHUNK_SIZE * it->first + glm::ivec3(y, CHUNK_SIZE - 1, z) + offset));
-                    }
+                /* no surfaces on either side, so a single union */
+                if (ch->is_uniform() && (!other || other->is_uniform())) {
+                    join(&ch->uniform_topo, other_pos, other ? &other->uniform_topo : nullptr);
+                    continue;
                 }
 
-                bl = it->second->blocks.get(y, z, 0);
-                to = it->second->topo.get(y, z, 0);
+                /* our face which looks at other, and the face of other
+                 * which looks back */
+                int axis = i >> 1;
+                int ours = (i & 1) ? 0 : CHUNK_SIZE - 1;
+                for (int v = 0; v < CHUNK_SIZE; v++) {
+                    for (int u = 0; u < CHUNK_SIZE; u++) {
+                        glm::ivec3 p;
+                        p[axis] = ours;
+                        p[(axis + 1) % 3] = u;
+                        p[(axis + 2) % 3] = v;
+
+                        if (!ch->is_uniform() && !air_permeable((*ch->blocks->surfs.get(p.x, p.y, p.z))[i])) {
+                            continue;
+                        }
 
-                for (int i = 0; i < 6; i++) {
-                    if (air_permeable(bl->surfs[i])) {
-                        glm::ivec3 offset = dirs[i];
-                        topo_unite(to,
-                            get_topo_info(CHUNK_SIZE * it->first + glm::ivec3(y, z, 0) + offset));
+                        glm::ivec3 q = p;
+                        q[axis] = CHUNK_SIZE - 1 - ours;
+                        join(ch->get_topo(p.x, p.y, p.z), other_pos,
+                             other ? other->get_topo(q.x, q.y, q.z) : nullptr);
                     }
                 }
+            }
+        }
+    }, threads);
 
-                bl = it->second->blocks.get(y, z, CHUNK_SIZE - 1);
-                to = it->second->topo.get(y, z, CHUNK_SIZE - 1);
+    for (auto &band : bands) {
+        for (auto &d : band.deferred) {
+            topo_unite(d.first, d.second);
+        }
+        topo_unite(&band.outside, &outside_topo_info);
+    }
 
-                for (int i = 0; i < 6; i++) {
-                    if (air_permeable(bl->surfs[i])) {
-                        glm::ivec3 offset = dirs[i];
-                        topo_unite(to,
-                            get_topo_info(CHUNK_SIZE * it->first + glm::ivec3(y, z, CHUNK_SIZE - 1) + offset));
-                    }
-                }
-            }
+    /* the stand-ins go away at the end, so none may be left the root */
+    topo_info *outside_root = topo_find(&outside_topo_info);
+    for (auto &band : bands) {
+        if (outside_root == &band.outside) {
+            outside_root->p = &outside_topo_info;
+            outside_topo_info.p = &outside_topo_info;
+            break;
         }
     }
 
-    /* 3/ finalize, and accumulate sizes */
-    for (auto it = chunks.begin(); it != chunks.end(); it++) {
-        for (int z = 0; z < CHUNK_SIZE; z++) {
-            for (int y = 0; y < CHUNK_SIZE; y++) {
-                for (int x = 0; x < CHUNK_SIZE; x++) {
-                    topo_info *t = topo_find(it->second->topo.get(x, y, z));
-                    t->size++;
-                }
+    /* 3/ finalize, and accumulate sizes. each component gets a root of
+     * its own, and every cell is left pointing straight at it, so that no
+     * cell is ever on another's path to its root. */
+    for (auto &rc : work) {
+        for (auto t : rc.cells) {
+            topo_info *r = topo_find(t);
+            if (r != &outside_topo_info && !root_storage.owner_of(r)) {
+                r->p = new_topo_root(r);
             }
+            topo_find(t)->size += t->size;
+        }
+
+        if (!rc.ch->is_uniform()) {
+            rc.ch->uniform_topo.p = rc.ch->blocks->cell_topo(0)->p;
         }
     }
 
-    /* 4/ fixup zone_info */
-    std::unordered_map<topo_info *, zone_info *> old_zones(std::move(zones));
-    for (auto it : old_zones) {
-        insert_zone(topo_find(it.first), it.second);
+    for (auto &band : bands) {
+        topo_find(&band.outside);
     }
+
+    topo_find(&outside_topo_info);
+
+    /* 4/ fixup zones: each goes to the new root of its old one */
+    outside_zone = 0;
+    for (unsigned id = 1; id < zone_data.size(); id++) {
+        if (zone_root[id]) {
+            attach_zone(this, topo_find(zone_root[id]), id);
+        }
+    }
+
+    for (auto r : old_roots) {
+        root_storage.free(r);
+    }
+    num_dead_roots = 0;
+
+    bump_topo_epoch();
 }
 
 
@@ -701,16 +1627,22 @@ ship_space::validate()
     bool pass = true;
 
     for (auto ch : chunks) {
+        /* a uniform chunk has no surfaces of its own. any surface on its
+         * boundary is checked from the far side. */
+        if (ch.second->is_uniform()) {
+            continue;
+        }
+
         for (int z = 0; z < CHUNK_SIZE; z++) {
             for (int y = 0; y < CHUNK_SIZE; y++) {
                 for (int x = 0; x < CHUNK_SIZE; x++) {
-                    block *bl = ch.second->blocks.get(x, y, z);
+                    block bl = ch.second->get_block(x, y, z);
                     for (int face = 0; face < 6; face++) {
                         glm::ivec3 offset = dirs[face];
                         glm::ivec3 other_coord = CHUNK_SIZE * ch.first + glm::ivec3(x, y, z) + offset;
-                        block *other = get_block(other_coord);
+                        const_block other = peek_block(other_coord);
 
-                        if (bl->surfs[face]) {
+                        if (bl.surfs[face]) {
                             /* 1/ every surface must be consistent with its far side. this implies that the
                              *    far side *block* must also exist, so that the surface can
                              */
@@ -719,14 +1651,14 @@ ship_space::validate()
                                         other_coord.x, other_coord.y, other_coord.z, face ^ 1);
                                 pass = false;
                             }
-                            else if (other->surfs[face ^ 1] != bl->surfs[face]) {
+                            else if (other.surfs[face ^ 1] != bl.surfs[face]) {
                                 printf("validate(): inconsistent surface %d %d %d face %d\n",
                                         other_coord.x, other_coord.y, other_coord.z, face ^ 1);
                                 pass = false;
                             }
 
                             /* 2/ every surface must be supported by framing on at least one side */
-                            if (bl->type != block_frame && (!other || other->type != block_frame)) {
+                            if (*bl.type != block_frame && (!other || *other.type != block_frame)) {
                                 printf("validate(): %d %d %d face %d has no supporting frame\n",
                                         other_coord.x - offset.x, other_coord.y - offset.y,
                                         other_coord.z - offset.z, face);
@@ -753,78 +1685,96 @@ ship_space::set_surface(glm::ivec3 a, glm::ivec3 b, surface_index index, surface
     auto block = ensure_block(a);
     auto other_block = ensure_block(b);
 
-    auto old = block->surfs[index];
+    auto old = block.surfs[index];
 
     if (old == st)
         return;
 
-    block->surfs[index] = st;
-    get_chunk_containing(a)->dirty();
+    chunk *ch = get_chunk_containing(a);
+    chunk *other_ch = get_chunk_containing(b);
+
+    block.surfs[index] = st;
+    mark_block_dirty(a);
 
-    other_block->surfs[index ^ 1] = st;
-    get_chunk_containing(b)->dirty();
+    other_block.surfs[index ^ 1] = st;
+    mark_block_dirty(b);
 
+    /* only a surface within a chunk changes its cells; one between chunks
+     * just joins or parts the cells either side */
     if (air_permeable(st) && !air_permeable(old)) {
         update_topology_for_remove_surface(a, b);
+        if (ch == other_ch) {
+            mark_cells_dirty(ch);
+        }
     }
     else if (air_permeable(old) && !air_permeable(st)) {
+        if (ch == other_ch) {
+            mark_cells_dirty(ch);
+        }
         update_topology_for_add_surface(a, b, index);
     }
 
     if (st == surface_none) {
-        block->has_wire[index] = false;
-        other_block->has_wire[index ^ 1] = false;
-        block->wire_bits[index] = 0;
-        other_block->wire_bits[index ^ 1] = 0;
+        block.set_has_wire(index, false);
+        other_block.set_has_wire(index ^ 1, false);
+        block.wire_bits[index] = 0;
+        other_block.wire_bits[index ^ 1] = 0;
     }
 }
 
 void
 ship_space::remove_block(glm::ivec3 p)
 {
-    block *bl = get_block(p);
+    block bl = get_block(p);
 
     /* block removal */
-    bl->type = block_empty;
+    *bl.type = block_empty;
 
     /* strip any orphaned surfaces */
     for (int index = 0; index < 6; index++) {
-        if (bl->surfs[index]) {
+        if (bl.surfs[index]) {
 
             auto s = surface_index_to_normal(index);
 
             auto r = p + s;
-            block *other_side = get_block(r);
+            const_block other_side = peek_block(r);
 
-            if (other_side->type != block_frame) {
+            if (*other_side.type != block_frame) {
                 set_surface(p, r, (surface_index)index, surface_none);
-                remove_ents_from_surface(p, index);
-                remove_ents_from_surface(r, index ^ 1);
+
+                if (edit_depth) {
+                    stripped_chunks.insert(get_chunk_coord_containing(p));
+                    stripped_chunks.insert(get_chunk_coord_containing(r));
+                }
+                else {
+                    remove_ents_from_surface(p, index);
+                    remove_ents_from_surface(r, index ^ 1);
+                }
             }
         }
     }
 
-    get_chunk_containing(p)->dirty();
+    mark_block_dirty(p);
 }
 
 bool ship_space::find_next_block(glm::ivec3 start, glm::ivec3 dir, unsigned limit, glm::ivec3 *found) {
-    auto cur = start + dir;
+    block_cursor cur(this, start + dir);
 
-    block *bl = nullptr;
-    while ((bl = get_block(cur)) && bl->type != block_frame && limit > 0) {
-        cur += dir;
+    const_block bl;
+    while ((bl = cur.get()) && *bl.type != block_frame && limit > 0) {
+        cur.step(dir);
         limit--;
     }
 
-    if (bl && bl->type == block_frame) {
-        *found = cur;
+    if (bl && *bl.type == block_frame) {
+        *found = cur.pos;
         return true;
     }
 
     return false;
 }
 
-block *ship_space::get_block_neighbor(glm::ivec3 block, enum surface_index si) {
+block ship_space::get_block_neighbor(glm::ivec3 block, enum surface_index si) {
     glm::ivec3 t = block + surface_index_to_normal(si);
 
     ensure_block(t);
@@ -832,6 +1782,8 @@ block *ship_space::get_block_neighbor(glm::ivec3 block, enum surface_index si) {
 }
 
 void ship_space::cut_out_cuboid(glm::ivec3 mins, glm::ivec3 maxs, surface_type type) {
+    begin_edit();
+
     for (auto i = mins.x - 1; i <= maxs.x + 1; i++) {
         for (auto j = mins.y - 1; j <= maxs.y + 1; j++) {
             for (auto k = mins.z - 1; k <= maxs.z + 1; k++) {
@@ -840,10 +1792,10 @@ void ship_space::cut_out_cuboid(glm::ivec3 mins, glm::ivec3 maxs, surface_type t
 
                 // Convert untouched surroundings to frame
                 auto bl = get_block(p);
-                if (bl->type == block_untouched)
-                    bl->type = block_frame;
+                if (*bl.type == block_untouched)
+                    *bl.type = block_frame;
 
-                get_chunk_containing(p)->dirty();
+                mark_block_dirty(p);
             }
         }
     }
@@ -856,61 +1808,132 @@ void ship_space::cut_out_cuboid(glm::ivec3 mins, glm::ivec3 maxs, surface_type t
 
                 if (i == mins.x) {
                     auto b = p + surface_index_to_normal(surface_xm);
-                    if (get_block(b)->type == block_frame) {
+                    if (*peek_block(b).type == block_frame) {
                         set_surface(b, p, surface_xp, type);
                     }
                 }
                 if (i == maxs.x) {
                     auto b = p + surface_index_to_normal(surface_xp);
-                    if (get_block(b)->type == block_frame) {
+                    if (*peek_block(b).type == block_frame) {
                         set_surface(b, p, surface_xm, type);
                     }
                 }
 
                 if (j == mins.y) {
                     auto b = p + surface_index_to_normal(surface_ym);
-                    if (get_block(b)->type == block_frame) {
+                    if (*peek_block(b).type == block_frame) {
                         set_surface(b, p, surface_yp, type);
                     }
                 }
                 if (j == maxs.y) {
                     auto b = p + surface_index_to_normal(surface_yp);
-                    if (get_block(b)->type == block_frame) {
+                    if (*peek_block(b).type == block_frame) {
                         set_surface(b, p, surface_ym, type);
                     }
                 }
 
                 if (k == mins.z) {
                     auto b = p + surface_index_to_normal(surface_zm);
-                    if (get_block(b)->type == block_frame) {
+                    if (*peek_block(b).type == block_frame) {
                         set_surface(b, p, surface_zp, type);
                     }
                 }
                 if (k == maxs.z) {
                     auto b = p + surface_index_to_normal(surface_zp);
-                    if (get_block(b)->type == block_frame) {
+                    if (*peek_block(b).type == block_frame) {
                         set_surface(b, p, surface_zm, type);
                     }
                 }
             }
         }
     }
+
+    commit_edit();
+}
+
+void
+ship_space::add_attachment(c_entity ce, glm::ivec3 p, int face)
+{
+    attachments[get_chunk_coord_containing(p)].push_back({ce, p, face});
+}
+
+void
+ship_space::remove_attachment(c_entity ce, glm::ivec3 p)
+{
+    auto it = attachments.find(get_chunk_coord_containing(p));
+    if (it == attachments.end()) {
+        return;
+    }
+
+    auto &refs = it->second;
+    for (auto i = 0u; i < refs.size(); i++) {
+        if (refs[i].ce == ce) {
+            refs[i] = refs.back();
+            refs.pop_back();
+            break;
+        }
+    }
+
+    if (refs.empty()) {
+        attachments.erase(it);
+    }
+}
+
+void
+ship_space::entities_on_surface(glm::ivec3 p, int face, std::vector<c_entity> &out)
+{
+    auto it = attachments.find(get_chunk_coord_containing(p));
+    if (it == attachments.end()) {
+        return;
+    }
+
+    for (auto &ref : it->second) {
+        if (ref.block == p && ref.face == face) {
+            out.push_back(ref.ce);
+        }
+    }
+}
+
+void
+ship_space::entities_attached_in_chunk(glm::ivec3 chunk_pos, std::vector<surface_attachment_ref> &out)
+{
+    auto it = attachments.find(chunk_pos);
+    if (it != attachments.end()) {
+        out.insert(out.end(), it->second.begin(), it->second.end());
+    }
 }
 
+/* every topo node lives either in a chunk (its uniform node) or in a
+ * chunk's block data, and both come out of our pools -- so the pools can
+ * tell us which one t is in, without searching the chunks. a cell's node
+ * is that of its head, so gives the head's position. */
 bool ship_space::topo_to_pos(topo_info *t, glm::ivec3* out) {
-    for (auto chunk : chunks) {
-        auto a = chunk.second->topo.get(0, 0, 0);
+    if (topo_root *r = root_storage.owner_of(t)) {
+        return t == &r->node && topo_to_pos(r->rep, out);
+    }
+
+    if (chunk *ch = chunk_storage.owner_of(t)) {
+        if (t != &ch->uniform_topo)
+            return false;
+
+        *out = ch->pos * CHUNK_SIZE;
+        return true;
+    }
+
+    if (chunk_blocks *bl = block_storage.owner_of(t)) {
+        auto a = bl->topo.get(0, 0, 0);
         auto b = a + CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
 
         if (t < a || t >= b)
-            continue;
+            return false;
 
-        auto index = t - a;
-        auto local = glm::ivec3(index % CHUNK_SIZE,
+        /* topo is laid out [x][y][z] */
+        auto index = (int)(t - a);
+        auto local = glm::ivec3(index / CHUNK_SIZE / CHUNK_SIZE,
             (index / CHUNK_SIZE) % CHUNK_SIZE,
-            (index / CHUNK_SIZE / CHUNK_SIZE));
+            index % CHUNK_SIZE);
 
-        *out = chunk.first * CHUNK_SIZE + local;
+        *out = bl->owner->pos * CHUNK_SIZE + local;
         return true;
     }
 
@@ -4,17 +4,35 @@
 #include <set>
 #include <unordered_map>
 #include <array>
+#include <vector>
 
 #include "block.h"
 #include "common.h"
 #include "component/component_manager.h"
 #include "chunk.h"
+#include "chunk_index.h"
+#include "chunk_pool.h"
+#include "gas_flow.h"
+#include "pressure_field.h"
 #include "wiring/wiring.h"
 #include "wiring/wiring_data.h"
 #include <unordered_set>
 
 extern void remove_ents_from_surface(glm::ivec3 b, int face);
 
+/* the root of an atmo component. the topo nodes of cells and uniform
+ * chunks (see basic_chunk_blocks::cells) only ever point at these, or at
+ * the outside node, never at each other, so a piece of a component can be
+ * relabelled without disturbing the rest. rep is some cell or chunk node in
+ * the component, for finding a position for it. zone is the id of the
+ * component's zone, or 0 if it has none.
+ */
+struct topo_root {
+    topo_info node;
+    topo_info *rep;
+    unsigned zone;
+};
+
 struct ivec3_hash {
   size_t operator()(const glm::ivec3 &v) const {
       std::hash<int> h;
@@ -44,8 +62,38 @@ struct ship_space {
     glm::ivec3 mins;
     glm::ivec3 maxs;
 
-    std::unordered_map<glm::ivec3, chunk*, ivec3_hash> chunks;
-    std::unordered_map<topo_info *, zone_info *> zones;
+    /* memory for every chunk in the ship, and for the per-block data of
+     * those which aren't uniform; see chunk_pool */
+    chunk_pool chunk_storage;
+    chunk_blocks_pool block_storage;
+    chunk_index chunks;
+
+    /* for each axis, where the chunks are along every line of chunks
+     * parallel to it. keyed by chunk coords with that axis zeroed; the set
+     * holds the coordinate along the axis. see possibly_enclosed()
+     */
+    std::unordered_map<glm::ivec3, std::set<int>, ivec3_hash> chunk_lines[3];
+
+    /* the gas in every component which has any, all in one array. a zone
+     * is found by the id kept in its component's root (topo_root::zone, or
+     * outside_zone while the outside node is the root); id 0 is never
+     * used, and means none. zone_root[id] is the root holding id, or null
+     * if id is free; freed ids are handed out again first. pointers into
+     * zone_data are only good until the next zone is made.
+     */
+    std::vector<zone_info> zone_data;
+    std::vector<topo_info *> zone_root;
+    std::vector<unsigned> free_zones;
+    unsigned outside_zone;
+
+    /* moved on whenever the component or zone of some block may have
+     * changed: on every unify, split and rebuild, and when a zone is made.
+     * anything which keeps a zone id for a block (see cached_zone()) need
+     * only look it up again once this has moved on. every ship draws its
+     * epochs from the one counter, which only goes up and starts at 1, so
+     * an epoch kept from another ship -- or of 0 -- is never current. */
+    unsigned topo_epoch;
+    void bump_topo_epoch();
 
     // fixed pools of networks
     // trade-off of contiguous memory access and unused memory
@@ -63,12 +111,21 @@ struct ship_space {
     /* create an empty ship_space */
     ship_space();
 
-    /* returns a block or null
+    /* returns a block, which is null if there is no chunk there
      * finds the block at the position (x,y,z) within
      * the whole ship_space
      * will move across chunks
+     *
+     * the block may be written through, so this expands a uniform chunk;
+     * use peek_block() for reading.
      */
-    block * get_block(glm::ivec3 block);
+    block get_block(glm::ivec3 block);
+
+    /* as get_block(), but read-only. cheap on uniform chunks */
+    const_block peek_block(glm::ivec3 block);
+
+    /* give ch its own per-block data, if it is uniform */
+    void expand_chunk(chunk *ch);
 
     topo_info * get_topo_info(glm::ivec3 block);
 
@@ -82,6 +139,9 @@ struct ship_space {
      */
     chunk * get_chunk(glm::ivec3 chunk);
 
+    /* the chunks across each face of ch, null where there are none */
+    void get_chunk_neighbours(chunk *ch, chunk *out[face_count]);
+
     /* returns a pointer to a new ship space
      * this ship space will have 2 x 2 rooms and will be 1 room tall
      * each room will have a floor and 4 walls of framing 
@@ -99,27 +159,139 @@ struct ship_space {
      *
      * this will instantiate a new containing chunk if necessary
      */
-    block * ensure_block(glm::ivec3 block);
+    block ensure_block(glm::ivec3 block);
 
     /* ensure that the specified chunk exists
      *
-     * this will instantiate a new chunk if necessary
+     * this will instantiate a new chunk if necessary, along with any
+     * missing chunks it might enclose
      */
     chunk * ensure_chunk(glm::ivec3 chunk);
 
+    bool has_chunk_along(glm::ivec3 v, int axis, int dir);
+    bool possibly_enclosed(glm::ivec3 v);
+    void add_to_chunk_lines(glm::ivec3 v);
+    void enclose_around(glm::ivec3 v);
+
+    /* zones, by the root t of their component. get_zone_info() is null if
+     * t has no zone; ensure_zone() makes an empty one. insert_zone() adds
+     * z's gas to t's zone, making it if need be, unless t is the outside. */
+    unsigned &zone_id(topo_info *t);
     zone_info *get_zone_info(topo_info *t);
-    void insert_zone(topo_info *t, zone_info *z);
+    zone_info *ensure_zone(topo_info *t);
+    void insert_zone(topo_info *t, zone_info const &z);
+    void free_zone(unsigned id);
+    size_t zone_count() const { return zone_data.size() - 1 - free_zones.size(); }
+
+    /* the zone id of block b, for callers which want it every tick. it is
+     * kept in *block, *epoch and *zone between calls, and only looked up
+     * again once b is another block or topo_epoch has moved on. */
+    unsigned cached_zone(glm::ivec3 b, glm::ivec3 *block, unsigned *epoch, unsigned *zone);
+
+    /* f(topo_info *root, zone_info &z) for every zone, in id order */
+    template<typename F> void for_each_zone(F const &f);
+
+    /* gas flow between zones (see gas_flow.h)
+     *
+     * an opening is a surface which blocks air, but which something is
+     * holding partly open: `width` is how much of the face is open, in
+     * blocks. openings are gathered afresh every tick by whatever holds
+     * them open (doors, see tick_door_openings), then tick_gas_flow()
+     * moves dt seconds of gas through those between different zones, or
+     * out to vacuum, and empties the outside.
+     */
+    struct opening {
+        glm::ivec3 p;
+        int face;
+        float width;
+    };
+    std::vector<opening> openings;
+    gas_flow flow;
+
+    /* per-block pressure while zones which just merged are still mixing;
+     * see pressure_field.h. off unless field.enabled is set. */
+    pressure_field field;
+    float pressure_at(glm::ivec3 p);
+
+    void add_opening(glm::ivec3 p, int face, float width);
+    void tick_gas_flow(float dt);
+
+    /* batched edits
+     *
+     * between begin_edit() and commit_edit(), block and surface changes
+     * are still made immediately, but the expensive consequences are
+     * deferred: each chunk touched is dirtied only once, and surfaces
+     * which might split a zone are only checked at commit, all in one
+     * flood fill (see split_topology) for the whole batch. batches may be
+     * nested; only the outermost commit does the work.
+     */
+    void begin_edit();
+    void commit_edit();
+
+    /* dirty ch now, or at commit if inside a batch */
+    void mark_dirty(chunk *ch);
+
+    /* dirty the chunk holding block p, and any other chunk holding one of
+     * p's neighbours: the mesher culls faces against the next block over,
+     * so an edit on the edge of a chunk can change the one beside it */
+    void mark_block_dirty(glm::ivec3 p);
+
+    /* label ch's cells again now, or at commit if inside a batch */
+    void mark_cells_dirty(chunk *ch);
+    void update_cells(chunk *ch);
+
+    int edit_depth;
+    std::unordered_set<chunk *> edit_dirty;
+    std::unordered_set<chunk *> cells_dirty;
+
+    /* chunks in which remove_block has stripped surfaces during a batch.
+     * entities left on a surface which is gone at commit are popped then,
+     * found a chunk at a time rather than a surface at a time. */
+    std::unordered_set<glm::ivec3, ivec3_hash> stripped_chunks;
+    void pop_stripped_attachments();
+
+    struct pending_split {
+        glm::ivec3 a, b;
+        int face;
+    };
+    std::vector<pending_split> pending_splits;
+
+    bool may_split(pending_split const &s);
+    void apply_pending_splits();
+    void split_topology(std::vector<pending_split> const &splits);
+
+    /* append the nodes topo_info tells apart in the component holding
+     * block p -- each uniform chunk, and each cell of an expanded chunk --
+     * found by a flood fill of that component alone. the outside has none:
+     * it is everything past the last chunk. */
+    struct component_node {
+        chunk *ch;
+        topo_info *t;
+    };
+    void component_nodes(glm::ivec3 p, std::vector<component_node> &out);
 
     /* topo info for open vacuum, so we know what pressure to force to zero */
     topo_info outside_topo_info;
-    void rebuild_topology();
+
+    /* every root made since the last rebuild, including those since
+     * merged away, which still forward to the merged root until
+     * free_dead_roots() gives them back */
+    slab_pool<topo_root> root_storage;
+    std::vector<topo_root *> topo_roots;
+    int num_dead_roots;         /* merged away since they were last freed */
+    topo_info *new_topo_root(topo_info *rep);
+    void free_dead_roots();
+
+    void rebuild_topology(unsigned threads = 0);
     void update_topology_for_remove_surface(glm::ivec3 a, glm::ivec3 b);
     void update_topology_for_add_surface(glm::ivec3 a, glm::ivec3 b, int face);
 
     int num_full_rebuilds;      /* number of full rebuilds (pretty slow) performed */
     int num_fast_unifys;        /* number of incremental unify operations performed */
-    int num_fast_nosplits;      /* number of rebuilds avoided because we proved them spurious */
-    int num_false_splits;       /* number of useless rebuilds taken */
+    int num_fast_nosplits;      /* number of splits avoided because we proved them spurious */
+    int num_false_splits;       /* number of flood fills which found nothing split */
+    int num_fast_splits;        /* number of pieces split off by relabelling just that piece */
+    int num_split_visits;       /* topo nodes visited by those flood fills, in total */
 
     bool validate();
 
@@ -134,7 +306,7 @@ struct ship_space {
      * will move across chunks
      * will call ensure_block if needed
      */
-    block *get_block_neighbor(glm::ivec3 block, enum surface_index si);
+    block get_block_neighbor(glm::ivec3 block, enum surface_index si);
 
     void remove_block(glm::ivec3 p);
 
@@ -143,13 +315,250 @@ struct ship_space {
      */
     void cut_out_cuboid(glm::ivec3 mins, glm::ivec3 maxs, surface_type type);
 
-    /* convert a topo ptr to the corresponding location. not expected to be fast. */
+    /* entities attached to surfaces, filed under the chunk of the block
+     * they hang on. there are only ever a handful per chunk, so finding
+     * the ones on one surface is a short scan rather than a walk over
+     * every surface attachment. the entities belong to the game, which
+     * keeps this up to date as it attaches, pops and destroys them (see
+     * entity_utils).
+     */
+    struct surface_attachment_ref {
+        c_entity ce;
+        glm::ivec3 block;
+        int face;
+    };
+    std::unordered_map<glm::ivec3, std::vector<surface_attachment_ref>, ivec3_hash> attachments;
+
+    void add_attachment(c_entity ce, glm::ivec3 p, int face);
+    /* ce, attached to a face of block p, isn't any more */
+    void remove_attachment(c_entity ce, glm::ivec3 p);
+
+    /* append the entities attached to face of block p */
+    void entities_on_surface(glm::ivec3 p, int face, std::vector<c_entity> &out);
+
+    /* append every attachment to a block of the chunk at chunk_pos, for
+     * edits which take away many surfaces at once */
+    void entities_attached_in_chunk(glm::ivec3 chunk_pos, std::vector<surface_attachment_ref> &out);
+
+    /* convert a topo ptr to the corresponding location. the pools' owner_of
+     * finds the root, chunk or block data t lives in, so this is a binary
+     * search over their slabs rather than a scan of the chunks. */
     bool topo_to_pos(topo_info *t, glm::ivec3* out);
 
     glm::ivec3 get_chunk_coord_containing(glm::ivec3 block);
+
+    /* region queries
+     *
+     * visit what lies in the box of blocks mins..maxs (inclusive), or in
+     * the blocks whose centers lie within a sphere. missing chunks are
+     * skipped, and the walk is chunk by chunk. when the box covers more
+     * chunks than the ship has, the chunk list is walked instead of the
+     * box, so the cost follows what is there rather than the volume asked
+     * about.
+     *
+     * for_each_block:   f(glm::ivec3 pos, const_block bl) for every
+     *                   block, as from peek_block().
+     * for_each_surface: f(glm::ivec3 pos, int face, surface_type st) for
+     *                   every face with a surface. a surface between two
+     *                   blocks in range is seen from both sides.
+     * for_each_wire:    f(glm::ivec3 pos, int face, block bl) for every
+     *                   face with wire on it.
+     *
+     * uniform chunks have no surfaces or wires, so the last two skip them
+     * entirely. f may edit the ship; chunks created meanwhile may or may
+     * not be visited.
+     */
+    template<typename F> void for_each_block(glm::ivec3 mins, glm::ivec3 maxs, F const &f);
+    template<typename F> void for_each_surface(glm::ivec3 mins, glm::ivec3 maxs, F const &f);
+    template<typename F> void for_each_wire(glm::ivec3 mins, glm::ivec3 maxs, F const &f);
+
+    template<typename F> void for_each_block_in_sphere(glm::vec3 c, float r, F const &f);
+    template<typename F> void for_each_surface_in_sphere(glm::vec3 c, float r, F const &f);
+    template<typename F> void for_each_wire_in_sphere(glm::vec3 c, float r, F const &f);
+
+    /* the chunks under the above: f(glm::ivec3 base, chunk *ch,
+     * glm::ivec3 lo, glm::ivec3 hi), where base is the chunk's first block
+     * and lo..hi the part of it (in local coords) inside the box. */
+    template<typename F> void for_each_chunk_in(glm::ivec3 mins, glm::ivec3 maxs, F const &f);
 };
 
 /* helper */
 topo_info *
 topo_find(topo_info *p);
 
+template<typename F>
+void
+ship_space::for_each_chunk_in(glm::ivec3 mins, glm::ivec3 maxs, F const &f)
+{
+    if (glm::any(glm::greaterThan(mins, maxs))) {
+        return;
+    }
+
+    glm::ivec3 cmins = get_chunk_coord_containing(mins);
+    glm::ivec3 cmaxs = get_chunk_coord_containing(maxs);
+
+    auto visit = [&](glm::ivec3 c, chunk *ch) {
+        glm::ivec3 base = CHUNK_SIZE * c;
+        f(base, ch,
+          glm::max(mins - base, glm::ivec3(0)),
+          glm::min(maxs - base, glm::ivec3(CHUNK_SIZE - 1)));
+    };
+
+    glm::ivec3 extent = cmaxs - cmins + glm::ivec3(1);
+    if ((size_t)extent.x * (size_t)extent.y * (size_t)extent.z > chunks.size()) {
+        /* by index, since f may add chunks */
+        for (size_t i = 0; i < chunks.size(); i++) {
+            auto e = chunks.begin()[i];
+            if (glm::all(glm::greaterThanEqual(e.first, cmins)) &&
+                    glm::all(glm::lessThanEqual(e.first, cmaxs))) {
+                visit(e.first, e.second);
+            }
+        }
+    }
+    else {
+        for (int x = cmins.x; x <= cmaxs.x; x++) {
+            for (int y = cmins.y; y <= cmaxs.y; y++) {
+                for (int z = cmins.z; z <= cmaxs.z; z++) {
+                    glm::ivec3 c(x, y, z);
+                    chunk *ch = get_chunk(c);
+                    if (ch) {
+                        visit(c, ch);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* blocks are visited x-slowest, z-fastest: the order fixed_cube lays them out in */
+template<typename F>
+void
+ship_space::for_each_block(glm::ivec3 mins, glm::ivec3 maxs, F const &f)
+{
+    for_each_chunk_in(mins, maxs, [&](glm::ivec3 base, chunk *ch, glm::ivec3 lo, glm::ivec3 hi) {
+        for (int x = lo.x; x <= hi.x; x++) {
+            for (int y = lo.y; y <= hi.y; y++) {
+                for (int z = lo.z; z <= hi.z; z++) {
+                    f(base + glm::ivec3(x, y, z), ch->peek_block(x, y, z));
+                }
+            }
+        }
+    });
+}
+
+template<typename F>
+void
+ship_space::for_each_surface(glm::ivec3 mins, glm::ivec3 maxs, F const &f)
+{
+    for_each_chunk_in(mins, maxs, [&](glm::ivec3 base, chunk *ch, glm::ivec3 lo, glm::ivec3 hi) {
+        if (ch->is_uniform()) {
+            return;
+        }
+
+        for (int x = lo.x; x <= hi.x; x++) {
+            for (int y = lo.y; y <= hi.y; y++) {
+                for (int z = lo.z; z <= hi.z; z++) {
+                    surface_type *surfs = *ch->blocks->surfs.get(x, y, z);
+                    for (int face = 0; face < 6; face++) {
+                        if (surfs[face] != surface_none) {
+                            f(base + glm::ivec3(x, y, z), face, surfs[face]);
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+template<typename F>
+void
+ship_space::for_each_wire(glm::ivec3 mins, glm::ivec3 maxs, F const &f)
+{
+    for_each_chunk_in(mins, maxs, [&](glm::ivec3 base, chunk *ch, glm::ivec3 lo, glm::ivec3 hi) {
+        if (ch->is_uniform()) {
+            return;
+        }
+
+        for (int x = lo.x; x <= hi.x; x++) {
+            for (int y = lo.y; y <= hi.y; y++) {
+                for (int z = lo.z; z <= hi.z; z++) {
+                    unsigned char mask = *ch->blocks->wire_masks.get(x, y, z);
+                    if (!mask) {
+                        continue;
+                    }
+
+                    block bl = ch->get_block(x, y, z);
+                    for (int face = 0; face < 6; face++) {
+                        if (mask & (1 << face)) {
+                            f(base + glm::ivec3(x, y, z), face, bl);
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+/* the box of blocks which might have their center within the sphere */
+static inline glm::ivec3
+sphere_mins(glm::vec3 c, float r)
+{
+    return glm::ivec3(glm::ceil(c - glm::vec3(r + 0.5f)));
+}
+
+static inline glm::ivec3
+sphere_maxs(glm::vec3 c, float r)
+{
+    return glm::ivec3(glm::floor(c + glm::vec3(r - 0.5f)));
+}
+
+static inline bool
+block_in_sphere(glm::ivec3 p, glm::vec3 c, float r)
+{
+    glm::vec3 d = glm::vec3(p) + glm::vec3(0.5f) - c;
+    return glm::dot(d, d) <= r * r;
+}
+
+template<typename F>
+void
+ship_space::for_each_zone(F const &f)
+{
+    for (unsigned id = 1; id < zone_data.size(); id++) {
+        if (zone_root[id]) {
+            f(zone_root[id], zone_data[id]);
+        }
+    }
+}
+
+template<typename F>
+void
+ship_space::for_each_block_in_sphere(glm::vec3 c, float r, F const &f)
+{
+    for_each_block(sphere_mins(c, r), sphere_maxs(c, r), [&](glm::ivec3 p, const_block bl) {
+        if (block_in_sphere(p, c, r)) {
+            f(p, bl);
+        }
+    });
+}
+
+template<typename F>
+void
+ship_space::for_each_surface_in_sphere(glm::vec3 c, float r, F const &f)
+{
+    for_each_surface(sphere_mins(c, r), sphere_maxs(c, r), [&](glm::ivec3 p, int face, surface_type st) {
+        if (block_in_sphere(p, c, r)) {
+            f(p, face, st);
+        }
+    });
+}
+
+template<typename F>
+void
+ship_space::for_each_wire_in_sphere(glm::vec3 c, float r, F const &f)
+{
+    for_each_wire(sphere_mins(c, r), sphere_maxs(c, r), [&](glm::ivec3 p, int face, block bl) {
+        if (block_in_sphere(p, c, r)) {
+            f(p, face, bl);
+        }
+    });
+}
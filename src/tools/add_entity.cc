@@ -54,7 +54,7 @@ struct add_entity_tool : tool {
             return false;
         }
 
-        block *bl = rc.block;
+        const_block bl = rc.block;
 
         if (!bl) {
             return false;
@@ -115,11 +115,11 @@ struct add_shaped_block_tool : tool
         /* ensure we can access this x,y,z */
         ship->ensure_block(rc.p);
 
-        block *bl = ship->get_block(rc.p);
+        block bl = ship->get_block(rc.p);
 
-        bl->type = type;
-        /* dirty the chunk */
-        ship->get_chunk_containing(rc.p)->dirty();
+        *bl.type = type;
+        /* dirty the chunk, and the next one over if this is on its edge */
+        ship->mark_block_dirty(rc.p);
     }
 
     void preview(frame_data *frame) override
@@ -61,12 +61,12 @@ struct paint_surface_tool : tool
         if (!rc.hit)
             return false;
 
-        auto *block = rc.block;
-        auto *other = ship->get_block(rc.p);
+        auto block = rc.block;
+        auto other = ship->peek_block(rc.p);
 
         // if we've started, only allow same plane
         if (state == paint_state::started) {
-            if (other && other->type != block_empty && other->type != block_untouched) {
+            if (other && *other.type != block_empty && *other.type != block_untouched) {
                 return false;
             }
 
@@ -74,7 +74,7 @@ struct paint_surface_tool : tool
                 return false;
         }
 
-        return (block && block->type == block_frame);
+        return (block && *block.type == block_frame);
     }
 
     void use() override {
@@ -95,7 +95,7 @@ struct paint_surface_tool : tool
             case paint_state::idle: {
                 start_block = rc.bl;
                 start_index = si;
-                select_type = rc.block->surfs[index];
+                select_type = rc.block.surfs[index];
 
                 state = paint_state::started;
                 break;
@@ -108,19 +108,18 @@ struct paint_surface_tool : tool
         auto min = glm::min(start_block, end);
         auto max = glm::max(start_block, end);
 
-        for (auto k = min.z; k <= max.z; k++) {
-            for (auto j = min.y; j <= max.y; j++) {
-                for (auto i = min.x; i <= max.x; i++) {
-                    auto pos = glm::ivec3(i, j, k);
-                    auto block = ship->get_block(pos);
-                    if (!block || block->type != block_frame || (mode == replace_mode::match && block->surfs[start_index] != select_type)) {
-                        continue;
-                    }
+        /* one topology update for the whole area, not one per surface */
+        ship->begin_edit();
 
-                    ship->set_surface(pos, pos + surface_index_to_normal(start_index), start_index, replace_type);
-                }
+        ship->for_each_block(min, max, [&](glm::ivec3 pos, const_block block) {
+            if (*block.type != block_frame || (mode == replace_mode::match && block.surfs[start_index] != select_type)) {
+                return;
             }
-        }
+
+            ship->set_surface(pos, pos + surface_index_to_normal(start_index), start_index, replace_type);
+        });
+
+        ship->commit_edit();
     }
 
     void alt_use() override {
@@ -194,23 +193,17 @@ struct paint_surface_tool : tool
                 auto min = glm::min(start_block, rc.bl);
                 auto max = glm::max(start_block, rc.bl);
 
-                for (auto k = min.z; k <= max.z; k++) {
-                    for (auto j = min.y; j <= max.y; j++) {
-                        for (auto i = min.x; i <= max.x; i++) {
-                            auto pos = glm::ivec3(i, j, k);
-                            auto block = ship->get_block(pos);
-                            if (!block || block->type != block_frame || (mode == replace_mode::match && block->surfs[start_index] != select_type)) {
-                                continue;
-                            }
-
-                            auto mat = frame->alloc_aligned<mesh_instance>(1);
-                            mat.ptr->world_matrix = mat_block_surface(pos, index ^ 1);
-                            mat.ptr->color = glm::vec4(1.f, 0.f, 0.f, 1.f);
-                            mat.bind(1, frame);
-                            draw_mesh(mesh->hw);
-                        }
+                ship->for_each_block(min, max, [&](glm::ivec3 pos, const_block block) {
+                    if (*block.type != block_frame || (mode == replace_mode::match && block.surfs[start_index] != select_type)) {
+                        return;
                     }
-                }
+
+                    auto mat = frame->alloc_aligned<mesh_instance>(1);
+                    mat.ptr->world_matrix = mat_block_surface(pos, index ^ 1);
+                    mat.ptr->color = glm::vec4(1.f, 0.f, 0.f, 1.f);
+                    mat.bind(1, frame);
+                    draw_mesh(mesh->hw);
+                });
 
 
                 break;
@@ -43,16 +43,16 @@ struct remove_block_tool : tool
         if (!can_use())
             return;
 
-        block *bl = rc.block;
-        if (bl->type != block_empty && bl->type != block_untouched) {
-            auto mesh = mesh_for_block_type(bl->type);
+        const_block bl = rc.block;
+        if (*bl.type != block_empty && *bl.type != block_untouched) {
+            auto mesh = mesh_for_block_type(*bl.type);
 
             auto mat = frame->alloc_aligned<mesh_instance>(1);
-            if (bl->type == block_frame) {
+            if (*bl.type == block_frame) {
                 mat.ptr->world_matrix = mat_position(glm::vec3(rc.bl));
             }
             else {
-                mat.ptr->world_matrix = get_corner_matrix(bl->type, rc.bl);
+                mat.ptr->world_matrix = get_corner_matrix(*bl.type, rc.bl);
             }
             mat.ptr->color = glm::vec4(1.f, 0.f, 0.f, 1.f);
             mat.bind(1, frame);
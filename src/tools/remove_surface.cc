@@ -5,6 +5,7 @@
 #include "../common.h"
 #include "../ship_space.h"
 #include "../mesh.h"
+#include "../mesher.h"
 #include "../block.h"
 #include "../player.h"
 #include "../physics.h"
@@ -17,6 +18,8 @@ extern GLuint overlay_shader;
 extern GLuint simple_shader;
 
 extern ship_space *ship;
+extern chunk_mesh_queue chunk_meshes;
+extern void prepare_chunks(bool wait);
 
 extern asset_manager asset_man;
 extern component_system_manager component_system_man;
@@ -40,11 +43,15 @@ struct remove_surface_tool : tool
 
         auto index = normal_to_surface_index(&rc);
 
-        auto const &mesh = asset_man.surf_kinds.at(rc.block->surfs[index]);
+        auto const &mesh = asset_man.surf_kinds.at(rc.block.surfs[index]);
 
         ship->set_surface(rc.bl, rc.p, (surface_index) index, surface_none);
-        glm::ivec3 ch = ship->get_chunk_coord_containing(rc.bl);
-        ship->get_chunk(ch)->prepare_phys(ch.x, ch.y, ch.z);
+
+        /* the popped surface is spawned into the gap, so the chunk's new
+         * collision shape is wanted before then: queue the edit, and wait
+         * for the workers to get through this chunk */
+        prepare_chunks(false);
+        chunk_meshes.land_chunk(ship->get_chunk_containing(rc.bl));
 
         /* remove any ents using the surface */
         remove_ents_from_surface(rc.p, index ^ 1);
@@ -65,7 +72,7 @@ struct remove_surface_tool : tool
 
         auto index = normal_to_surface_index(&rc);
 
-        auto &mesh = asset_man.surf_kinds.at(rc.block->surfs[index]).visual_mesh;
+        auto &mesh = asset_man.surf_kinds.at(rc.block.surfs[index]).visual_mesh;
 
         auto mat = frame->alloc_aligned<mesh_instance>(1);
         mat.ptr->world_matrix = mat_block_surface(glm::vec3(rc.bl), index ^ 1);
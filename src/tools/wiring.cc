@@ -1,6 +1,7 @@
 #include <epoxy/gl.h>
 
 #include "../asset_manager.h"
+#include "../block_cursor.h"
 #include "../common.h"
 #include "../ship_space.h"
 #include "../mesh.h"
@@ -43,30 +44,31 @@ static wire_pos from_rc(raycast_info_block const *rc) {
 
 static unsigned get_neighbor_bits(wire_pos w, std::unordered_set<wire_pos, wire_pos::hash> const & ws) {
     unsigned bits = 0u;
-    auto bl = ship->get_block(w.pos);
+    block_cursor at(ship, w.pos);
+    auto bl = at.get();
     for (auto i = 0u; i < 6u; i++) {
         if (i == w.face || i == (w.face ^ 1)) continue;
-        if (bl->surfs[i]) {
+        if (bl.surfs[i]) {
             // inside corner
             if (ws.count({ w.pos, i })) {
                 bits |= 1 << i;
             }
         }
         else {
-            auto np = w.pos + surface_index_to_normal(i);
-            auto n = ship->get_block(np);
-            if (n && n->surfs[w.face]) {
+            auto nc = at.neighbor(i);
+            auto n = nc.get();
+            if (n && n.surfs[w.face]) {
                 // straight along surface
-                if (ws.count({ np, w.face })) {
+                if (ws.count({ nc.pos, w.face })) {
                     bits |= 1 << i;
                 }
             }
             else {
-                auto rp = np + surface_index_to_normal(w.face);
-                auto r = ship->get_block(rp);
-                if (r && r->surfs[i ^ 1]) {
+                auto rc = nc.neighbor(w.face);
+                auto r = rc.get();
+                if (r && r.surfs[i ^ 1]) {
                     // outside corner
-                    if (ws.count({ rp, i ^ 1 })) {
+                    if (ws.count({ rc.pos, i ^ 1 })) {
                         bits |= 1 << i;
                     }
                 }
@@ -78,28 +80,29 @@ static unsigned get_neighbor_bits(wire_pos w, std::unordered_set<wire_pos, wire_
 
 template<typename T>
 static void for_each_neighbor(wire_pos w, T const & f) {
-    auto bl = ship->get_block(w.pos);
+    block_cursor at(ship, w.pos);
+    auto bl = at.get();
     for (auto i = 0u; i < 6u; i++) {
         // not the current face, and not the opposite one
         // (would require a span across the middle of the block)
         if (i != w.face && i != (w.face ^ 1)) {
-            if (bl->surfs[i]) {
+            if (bl.surfs[i]) {
                 // around an inside corner
                 f({ w.pos, i });
             }
             else {
                 // straight along the surface
-                auto np = w.pos + surface_index_to_normal(i);
-                auto n = ship->get_block(np);
-                if (n && n->surfs[w.face]) {
-                    f({ np, w.face });
+                auto nc = at.neighbor(i);
+                auto n = nc.get();
+                if (n && n.surfs[w.face]) {
+                    f({ nc.pos, w.face });
                 }
                 else {
                     // outside corner
-                    auto rp = np + surface_index_to_normal(w.face);
-                    auto r = ship->get_block(rp);
-                    if (r && r->surfs[i ^ 1]) {
-                        f({ rp, i ^ 1 });
+                    auto rc = nc.neighbor(w.face);
+                    auto r = rc.get();
+                    if (r && r.surfs[i ^ 1]) {
+                        f({ rc.pos, i ^ 1 });
                     }
                 }
             }
@@ -152,7 +155,7 @@ std::vector<wire_pos> find_path(wire_pos from, wire_pos to) {
 
         for_each_neighbor(wp, [&](wire_pos const &n) {
             auto cost = ws.g;
-            if (!ship->get_block(n.pos)->has_wire[n.face]) cost += 1.f;
+            if (!ship->peek_block(n.pos).has_wire(n.face)) cost += 1.f;
             auto is_new = state.find(n) == state.end();
             auto &ns = state[n];
             if (is_new || cost < ns.g) {
@@ -200,11 +203,11 @@ struct wiring_tool : tool
         case placing: {
             if (path.size()) {
                 for (auto &pe : path) {
-                    ship->get_block(pe.pos)->has_wire[pe.face] = true;
+                    ship->get_block(pe.pos).set_has_wire(pe.face, true);
                 }
                 std::unordered_set<wire_pos, wire_pos::hash> ps(path.begin(), path.end());
                 for (auto &pe : path) {
-                    ship->get_block(pe.pos)->wire_bits[pe.face] |= get_neighbor_bits(pe, ps);
+                    ship->get_block(pe.pos).wire_bits[pe.face] |= get_neighbor_bits(pe, ps);
                 }
                 state = idle;
             }
@@ -224,8 +227,8 @@ struct wiring_tool : tool
             return;
 
         auto p = from_rc(&rc);
-        ship->get_block(p.pos)->has_wire[p.face] = false;
-        ship->get_block(p.pos)->wire_bits[p.face] = 0;
+        ship->get_block(p.pos).set_has_wire(p.face, false);
+        ship->get_block(p.pos).wire_bits[p.face] = 0;
     }
 
     void preview(frame_data *frame) override
@@ -263,7 +266,7 @@ struct wiring_tool : tool
             glEnable(GL_BLEND);
             for (auto & pe : path) {
                 total_run++;
-                if (!ship->get_block(pe.pos)->has_wire[pe.face]) {
+                if (!ship->peek_block(pe.pos).has_wire(pe.face)) {
                     auto mat = frame->alloc_aligned<mesh_instance>(1);
                     mat.ptr->world_matrix = mat_block_face(glm::vec3(pe.pos), pe.face);
                     mat.ptr->color = glm::vec4(1.f, 1.f, 1.f, 1.f);
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <stdio.h>
+#include <vector>
+
+#include "../src/ship_space.h"
+
+/* the ship's index of entities attached to surfaces, as the game keeps it
+ * through attaching, popping and destroying them: each is found on its
+ * own surface and in its own chunk, and nowhere once gone. removing blocks
+ * pops whatever was on the surfaces taken away with them -- straight
+ * away on its own, and at commit in a batch, where the batch's chunks are
+ * each looked through once -- and nothing else.
+ */
+
+static ship_space *ship;
+static std::vector<c_entity> popped;
+
+/* what the game does: pop everything off the surface, which takes it out
+ * of the index */
+void
+remove_ents_from_surface(glm::ivec3 b, int face)
+{
+    std::vector<c_entity> ents;
+    ship->entities_on_surface(b, face, ents);
+
+    for (auto ce : ents) {
+        ship->remove_attachment(ce, b);
+        popped.push_back(ce);
+    }
+}
+
+static int bad = 0;
+
+static void
+check(bool ok, char const *what)
+{
+    if (!ok) {
+        printf("%s\n", what);
+        bad++;
+    }
+}
+
+static std::vector<c_entity>
+on_surface(glm::ivec3 p, int face)
+{
+    std::vector<c_entity> out;
+    ship->entities_on_surface(p, face, out);
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+static std::vector<c_entity>
+in_chunk(glm::ivec3 c)
+{
+    std::vector<ship_space::surface_attachment_ref> refs;
+    ship->entities_attached_in_chunk(c, refs);
+
+    std::vector<c_entity> out;
+    for (auto &r : refs) {
+        out.push_back(r.ce);
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+static bool
+was_popped(c_entity ce)
+{
+    return std::count(popped.begin(), popped.end(), ce) == 1;
+}
+
+/* a surface on both sides, with an entity on each side of it */
+static void
+put_surface(glm::ivec3 p, int face, c_entity near, c_entity far)
+{
+    glm::ivec3 q = p + surface_index_to_normal((surface_index)face);
+    ship->set_surface(p, q, (surface_index)face, surface_wall);
+    ship->add_attachment(near, p, face);
+    ship->add_attachment(far, q, face ^ 1);
+}
+
+int
+main(void)
+{
+    int const c1 = CHUNK_SIZE;          /* the first block of chunk 1 */
+    int const n = 2 * CHUNK_SIZE - 1;   /* the last block of chunk 1 */
+    ship = new ship_space;
+
+    for (int z = 0; z <= n; z++) {
+        for (int y = 0; y <= n; y++) {
+            for (int x = 0; x <= n; x++) {
+                *ship->ensure_block(glm::ivec3(x, y, z)).type = block_frame;
+            }
+        }
+    }
+
+    c_entity a{1}, b{2}, c{3}, d{4}, e{5}, f{6}, g{7}, h{8};
+
+    /* attach: found on their surface, and in their chunk */
+    put_surface(glm::ivec3(c1 - 1, 3, 3), surface_xp, a, b);    /* across chunks 0 and 1 */
+    put_surface(glm::ivec3(1, 3, 3), surface_xp, c, d);         /* the edge of the cut below */
+    put_surface(glm::ivec3(n - 1, n - 1, n - 1), surface_zp, e, f);
+    put_surface(glm::ivec3(n - 1, 1, 1), surface_xp, g, h);
+
+    check(on_surface(glm::ivec3(c1 - 1, 3, 3), surface_xp) == std::vector<c_entity>{a}, "a not on its surface");
+    check(on_surface(glm::ivec3(c1, 3, 3), surface_xm) == std::vector<c_entity>{b}, "b not on its surface");
+    check(on_surface(glm::ivec3(c1 - 1, 3, 3), surface_xm).empty(), "something on a bare surface");
+    check(in_chunk(glm::ivec3(0, 0, 0)) == (std::vector<c_entity>{a, c, d}), "chunk 0 doesn't hold a, c and d");
+    check(in_chunk(glm::ivec3(1, 1, 1)) == (std::vector<c_entity>{e, f}), "chunk 1,1,1 doesn't hold e and f");
+
+    /* move one, as attaching an attached entity does */
+    ship->remove_attachment(f, glm::ivec3(n - 1, n - 1, n));
+    ship->add_attachment(f, glm::ivec3(n - 1, n - 1, n - 1), surface_zp);
+    check(on_surface(glm::ivec3(n - 1, n - 1, n - 1), surface_zp) == (std::vector<c_entity>{e, f}), "f didn't move");
+    check(on_surface(glm::ivec3(n - 1, n - 1, n), surface_zm).empty(), "f is still where it was");
+
+    /* pop or destroy: gone, and the chunk with it once it's empty */
+    ship->remove_attachment(e, glm::ivec3(n - 1, n - 1, n - 1));
+    ship->remove_attachment(f, glm::ivec3(n - 1, n - 1, n - 1));
+    check(in_chunk(glm::ivec3(1, 1, 1)).empty(), "e and f are still in chunk 1,1,1");
+    check(ship->attachments.find(glm::ivec3(1, 1, 1)) == ship->attachments.end(), "chunk 1,1,1 is still filed");
+
+    /* a block on its own: g and h's surface has no frame left to hold it */
+    *ship->get_block(glm::ivec3(n, 1, 1)).type = block_empty;
+    ship->remove_block(glm::ivec3(n - 1, 1, 1));
+    check(was_popped(g) && was_popped(h) && popped.size() == 2, "removing a block didn't pop g and h");
+
+    /* a batch: a and b's surface goes with the blocks either side. c and
+     * d's is on the edge of the cut, and stays, framed from outside. */
+    popped.clear();
+    ship->cut_out_cuboid(glm::ivec3(2, 2, 2), glm::ivec3(c1), surface_wall);
+    check(was_popped(a) && was_popped(b), "cutting didn't pop a and b");
+    check(popped.size() == 2, "cutting popped something it shouldn't have");
+    check(on_surface(glm::ivec3(1, 3, 3), surface_xp) == std::vector<c_entity>{c}, "c came off");
+    check(on_surface(glm::ivec3(2, 3, 3), surface_xm) == std::vector<c_entity>{d}, "d came off");
+    check(ship->stripped_chunks.empty(), "the batch left chunks to look through");
+
+    delete ship;
+
+    printf("%d bad\n", bad);
+    return bad != 0;
+}
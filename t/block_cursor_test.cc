@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/block_cursor.h"
+
+/* a block_cursor must always agree with looking its position up from
+ * scratch. cursors are walked at random -- a block at a time by axis and
+ * by face, by small and large offsets, and by seeking -- across chunk
+ * boundaries in negative and positive space, through expanded chunks,
+ * uniform ones and missing ones. after every move its position, chunk and
+ * offset must add up, and get() and topo() must give just what peek_block
+ * and get_topo_info give there. neighbor() must leave the cursor alone.
+ */
+
+/* ship_space wants this from the game; nothing is attached here. */
+void
+remove_ents_from_surface(glm::ivec3, int)
+{
+}
+
+static int const extent = 3;   /* in chunks, each way from the origin */
+
+static bool
+agrees(ship_space *ship, block_cursor const &c, glm::ivec3 want)
+{
+    if (c.pos != want) {
+        printf("cursor at %d %d %d, should be at %d %d %d\n",
+               c.pos.x, c.pos.y, c.pos.z, want.x, want.y, want.z);
+        return false;
+    }
+
+    if (c.chunk_pos * CHUNK_SIZE + c.local != c.pos ||
+            glm::any(glm::lessThan(c.local, glm::ivec3(0))) ||
+            glm::any(glm::greaterThanEqual(c.local, glm::ivec3(CHUNK_SIZE)))) {
+        printf("%d %d %d: chunk and offset don't add up\n", want.x, want.y, want.z);
+        return false;
+    }
+
+    if (c.ch != ship->get_chunk(c.chunk_pos)) {
+        printf("%d %d %d: wrong chunk\n", want.x, want.y, want.z);
+        return false;
+    }
+
+    const_block a = c.get();
+    const_block b = ship->peek_block(want);
+    if (!a != !b) {
+        printf("%d %d %d: block where there's no chunk, or none where there is\n",
+               want.x, want.y, want.z);
+        return false;
+    }
+
+    /* a uniform chunk's blocks are shared data, of which each file has its
+     * own copy, so compare what they hold */
+    bool same = !a || (*a.type == *b.type && *a.wire_mask == *b.wire_mask);
+    for (int face = 0; a && face < 6; face++) {
+        same = same && a.surfs[face] == b.surfs[face];
+    }
+    if (!same) {
+        printf("%d %d %d: wrong block\n", want.x, want.y, want.z);
+        return false;
+    }
+
+    if (c.topo() != ship->get_topo_info(want)) {
+        printf("%d %d %d: wrong topo node\n", want.x, want.y, want.z);
+        return false;
+    }
+
+    return true;
+}
+
+static glm::ivec3
+random_block()
+{
+    int const n = extent * CHUNK_SIZE;
+    return glm::ivec3(rand() % (2 * n) - n, rand() % (2 * n) - n, rand() % (2 * n) - n);
+}
+
+int
+main(void)
+{
+    int bad = 0;
+    srand(1);
+
+    /* about half the chunks, some with blocks of their own */
+    auto *ship = new ship_space;
+    for (int k = -extent; k < extent; k++) {
+        for (int j = -extent; j < extent; j++) {
+            for (int i = -extent; i < extent; i++) {
+                if (rand() % 2) {
+                    ship->ensure_chunk(glm::ivec3(i, j, k));
+                }
+            }
+        }
+    }
+
+    for (int n = 0; n < 200; n++) {
+        glm::ivec3 p = random_block();
+        if (ship->get_chunk_containing(p)) {
+            block bl = ship->get_block(p);
+            *bl.type = block_frame;
+            bl.surfs[rand() % 6] = surface_wall;
+        }
+    }
+
+    ship->rebuild_topology(1);
+
+    for (int walk = 0; walk < 200 && !bad; walk++) {
+        glm::ivec3 want = random_block();
+        block_cursor c(ship, want);
+        if (!agrees(ship, c, want)) {
+            bad++;
+        }
+
+        for (int move = 0; move < 100 && !bad; move++) {
+            int kind = rand() % 5;
+            if (kind == 0) {
+                int axis = rand() % 3;
+                int d = rand() % 2 ? 1 : -1;
+                c.step(axis, d);
+                want[axis] += d;
+            }
+            else if (kind == 1) {
+                int face = rand() % 6;
+                c.step(face);
+                want += surface_index_to_normal((surface_index)face);
+            }
+            else if (kind == 2) {
+                /* unit steps, diagonals among them, and jumps */
+                int r = rand() % 4 ? 1 : 2 * CHUNK_SIZE;
+                glm::ivec3 d(rand() % (2 * r + 1) - r, rand() % (2 * r + 1) - r,
+                             rand() % (2 * r + 1) - r);
+                c.step(d);
+                want += d;
+            }
+            else if (kind == 3) {
+                want = random_block();
+                c.seek(want);
+            }
+            else {
+                int face = rand() % 6;
+                block_cursor n = c.neighbor(face);
+                if (!agrees(ship, n, want + surface_index_to_normal((surface_index)face))) {
+                    bad++;
+                }
+            }
+
+            if (!agrees(ship, c, want)) {
+                printf("walk %d, move %d (kind %d)\n", walk, move, kind);
+                bad++;
+            }
+        }
+    }
+
+    delete ship;
+
+    printf("%d bad\n", bad);
+    return bad != 0;
+}
@@ -0,0 +1,132 @@
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <tuple>
+
+#include "../src/chunk_index.h"
+
+/* the paged chunk index must behave as the sparse map it replaced: random
+ * sets, replacements and erases, spread over negative and positive space
+ * and far enough apart to grow the directory many times, are checked after
+ * each against a std::map. every coordinate in the box gives the same chunk
+ * (or none), and iteration gives each chunk present exactly once.
+ */
+
+struct coord_less {
+    bool operator()(glm::ivec3 a, glm::ivec3 b) const
+    {
+        return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+    }
+};
+
+typedef std::map<glm::ivec3, chunk *, coord_less> reference;
+
+static int const extent = 3 * CHUNK_INDEX_PAGE_SIZE;
+
+static glm::ivec3
+random_coord()
+{
+    return glm::ivec3(rand() % (2 * extent + 1) - extent,
+                      rand() % (2 * extent + 1) - extent,
+                      rand() % (2 * extent + 1) - extent);
+}
+
+static bool
+same_contents(chunk_index const &index, reference const &ref)
+{
+    for (int z = -extent - 1; z <= extent + 1; z++) {
+        for (int y = -extent - 1; y <= extent + 1; y++) {
+            for (int x = -extent - 1; x <= extent + 1; x++) {
+                glm::ivec3 v(x, y, z);
+                auto it = ref.find(v);
+                chunk *want = it == ref.end() ? nullptr : it->second;
+                if (index.get(v) != want) {
+                    printf("%d %d %d: wrong chunk\n", x, y, z);
+                    return false;
+                }
+            }
+        }
+    }
+
+    if (index.size() != ref.size()) {
+        printf("%zu chunks, should be %zu\n", index.size(), ref.size());
+        return false;
+    }
+
+    reference seen;
+    for (auto const &e : index) {
+        auto it = ref.find(e.first);
+        if (it == ref.end() || it->second != e.second || !seen.insert(e).second) {
+            printf("%d %d %d: iterated wrongly\n", e.first.x, e.first.y, e.first.z);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int
+main(void)
+{
+    int bad = 0;
+
+    /* the index never looks inside its chunks, so stand-ins will do */
+    static char stand_ins[64];
+
+    srand(1);
+    chunk_index index;
+    reference ref;
+
+    for (int op = 0; op < 400 && !bad; op++) {
+        glm::ivec3 v = random_coord();
+
+        /* mostly near what's there already, so replaces and erases hit */
+        if (!ref.empty() && rand() % 2) {
+            auto it = ref.begin();
+            std::advance(it, rand() % ref.size());
+            v = it->first;
+        }
+
+        int kind = rand() % 4;
+        if (kind == 0) {
+            index.erase(v);
+            ref.erase(v);
+        }
+        else if (kind == 1) {
+            /* setting null erases too */
+            index.set(v, nullptr);
+            ref.erase(v);
+        }
+        else {
+            chunk *ch = (chunk *)&stand_ins[rand() % 64];
+            index.set(v, ch);
+            ref[v] = ch;
+        }
+
+        if (op % 20 == 0 && !same_contents(index, ref)) {
+            printf("after op %d\n", op);
+            bad++;
+        }
+    }
+
+    if (!bad && !same_contents(index, ref)) {
+        bad++;
+    }
+
+    /* pages either side of zero are distinct: -1 is not 0 */
+    chunk_index signs;
+    signs.set(glm::ivec3(0), (chunk *)&stand_ins[0]);
+    signs.set(glm::ivec3(-1), (chunk *)&stand_ins[1]);
+    signs.set(glm::ivec3(-CHUNK_INDEX_PAGE_SIZE), (chunk *)&stand_ins[2]);
+    if (signs.get(glm::ivec3(0)) != (chunk *)&stand_ins[0] ||
+            signs.get(glm::ivec3(-1)) != (chunk *)&stand_ins[1] ||
+            signs.get(glm::ivec3(-CHUNK_INDEX_PAGE_SIZE)) != (chunk *)&stand_ins[2] ||
+            signs.get(glm::ivec3(CHUNK_INDEX_PAGE_SIZE - 1)) ||
+            signs.get(glm::ivec3(-CHUNK_INDEX_PAGE_SIZE - 1))) {
+        printf("chunks either side of zero mixed up\n");
+        bad++;
+    }
+
+    printf("%d bad\n", bad);
+    return bad != 0;
+}
@@ -1,12 +1,200 @@
+#include <stdint.h>
 #include <stdio.h>
-#include <assert.h>
-#include "../src/chunk.h"
+#include <vector>
 
+#include "../src/load.h"
+#include "../src/save.h"
+#include "../src/ship_space.h"
 
-/* some light manual testing of block and grid
+/* uniform chunks: a chunk nobody has written to is kept as just its type.
+ * reading it through peek_block gives that type, no surfaces and no wires,
+ * and leaves it uniform; writing through get_block expands it into blocks
+ * of that type, without moving it out of the component it was in.
+ *
+ * saved, such a chunk is just its INFO and a FILL lump, with no planes. a
+ * ship of uniform and expanded chunks survives a round trip: uniform ones
+ * stay uniform with their type, and expanded ones keep every block --
+ * except that an expanded chunk which holds nothing but its type comes
+ * back uniform.
  */
+
+/* ship_space wants this from the game; nothing is attached here. */
+void
+remove_ents_from_surface(glm::ivec3, int)
+{
+}
+
+static int bad = 0;
+
+static void
+check(bool ok, char const *what)
+{
+    if (!ok) {
+        printf("%s\n", what);
+        bad++;
+    }
+}
+
+static char const *const filename = "chunk_test.ship";
+
+/* does every block of the chunk read as a plain block of type t? */
+static bool
+all_plain(chunk *ch, block_type t)
+{
+    for (int z = 0; z < CHUNK_SIZE; z++) {
+        for (int y = 0; y < CHUNK_SIZE; y++) {
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                const_block bl = ch->peek_block(x, y, z);
+                if (*bl.type != t || *bl.wire_mask) {
+                    return false;
+                }
+                for (int face = 0; face < 6; face++) {
+                    if (bl.surfs[face] || bl.wire_bits[face]) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+/* do two chunks hold the same blocks? */
+static bool
+same_blocks(chunk *a, chunk *b)
+{
+    for (int z = 0; z < CHUNK_SIZE; z++) {
+        for (int y = 0; y < CHUNK_SIZE; y++) {
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                const_block p = a->peek_block(x, y, z);
+                const_block q = b->peek_block(x, y, z);
+                if (*p.type != *q.type || *p.wire_mask != *q.wire_mask) {
+                    return false;
+                }
+                for (int face = 0; face < 6; face++) {
+                    if (p.surfs[face] != q.surfs[face] || p.wire_bits[face] != q.wire_bits[face]) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+/* the tags of the lumps saved for each chunk, in order */
+static std::vector<std::vector<uint32_t>>
+saved_lumps()
+{
+    std::vector<std::vector<uint32_t>> out;
+    FILE *f = fopen(filename, "rb");
+    uint32_t head[2];
+
+    if (fread(head, sizeof(uint32_t), 2, f) != 2 || head[0] != fourcc("SHIP")) {
+        fclose(f);
+        return out;
+    }
+
+    while (fread(head, sizeof(uint32_t), 2, f) == 2) {
+        if (head[0] != fourcc("CHNK")) {
+            fseek(f, head[1], SEEK_CUR);
+            continue;
+        }
+
+        out.emplace_back();
+        long end = ftell(f) + head[1];
+        while (ftell(f) < end && fread(head, sizeof(uint32_t), 2, f) == 2) {
+            out.back().push_back(head[0]);
+            fseek(f, head[1], SEEK_CUR);
+        }
+    }
+
+    fclose(f);
+    return out;
+}
+
 int
 main(void)
 {
-}
+    /* a row of chunks: expanded, uniform frame, uniform empty, untouched,
+     * and one expanded but holding only frame */
+    auto *ship = new ship_space;
+    for (int i = 0; i < 5; i++) {
+        ship->ensure_chunk(glm::ivec3(i, 0, 0));
+    }
+
+    ship->get_chunk(glm::ivec3(1, 0, 0))->uniform_type = block_frame;
+    ship->get_chunk(glm::ivec3(2, 0, 0))->uniform_type = block_empty;
+
+    block bl = ship->get_block(glm::ivec3(1, 1, 1));
+    *bl.type = block_frame;
+    bl.surfs[surface_xp] = surface_wall;
+    ship->get_block(glm::ivec3(2, 1, 1)).surfs[surface_xm] = surface_wall;
+    bl.set_has_wire(surface_yp, true);
+    bl.wire_bits[surface_yp] = 3;
+
+    ship->get_chunk(glm::ivec3(4, 0, 0))->uniform_type = block_frame;
+    ship->expand_chunk(ship->get_chunk(glm::ivec3(4, 0, 0)));
+    ship->rebuild_topology();
+    check(ship->validate(), "the ship doesn't validate");
+
+    /* peek_block reads the type, and leaves the chunk alone */
+    chunk *frame = ship->get_chunk(glm::ivec3(1, 0, 0));
+    check(*ship->peek_block(glm::ivec3(CHUNK_SIZE + 2, 1, 1)).type == block_frame, "peek_block misread a uniform chunk");
+    check(all_plain(frame, block_frame), "a uniform chunk has surfaces or wires");
+    check(frame->is_uniform(), "peek_block expanded a uniform chunk");
+    check(!ship->peek_block(glm::ivec3(-1, 0, 0)), "peek_block found a block where there is no chunk");
 
+    save(ship, filename);
+
+    /* the uniform chunks are saved as nothing but their type */
+    auto lumps = saved_lumps();
+    std::vector<uint32_t> const fill{ fourcc("INFO"), fourcc("FILL") };
+    int uniform_saved = 0;
+    for (auto const &l : lumps) {
+        uniform_saved += l == fill;
+    }
+    check(lumps.size() == 5, "the wrong number of chunks was saved");
+    check(uniform_saved == 3, "the uniform chunks weren't saved as FILL");
+
+    auto *loaded = new ship_space;
+    load(loaded, filename);
+    remove(filename);
+
+    check(loaded->chunks.size() == 5, "the wrong number of chunks came back");
+    for (int i = 0; i < 5; i++) {
+        chunk *a = ship->get_chunk(glm::ivec3(i, 0, 0));
+        chunk *b = loaded->get_chunk(glm::ivec3(i, 0, 0));
+        if (!b) {
+            printf("chunk %d didn't come back\n", i);
+            bad++;
+            continue;
+        }
+
+        check(same_blocks(a, b), "a chunk came back with different blocks");
+        check(b->is_uniform() == (i != 0), "a chunk came back expanded, or uniform");
+        check(!b->is_uniform() || b->uniform_type == (i == 2 ? block_empty : i == 3 ? block_untouched : block_frame),
+              "a uniform chunk came back as the wrong type");
+    }
+
+    /* writing expands it into blocks of its type, in the same component */
+    glm::ivec3 p(2 * CHUNK_SIZE + 1, 2, 3);
+    chunk *empty = loaded->get_chunk(glm::ivec3(2, 0, 0));
+    topo_info *before = topo_find(loaded->get_topo_info(p));
+
+    block wb = loaded->get_block(p);
+    check(!empty->is_uniform(), "get_block didn't expand a uniform chunk");
+    check(all_plain(empty, block_empty), "an expanded chunk doesn't hold its type");
+    check(wb.type == empty->get_block(1, 2, 3).type, "get_block gave the wrong block");
+    check(topo_find(loaded->get_topo_info(p)) == before, "expanding moved the chunk to another component");
+    check(topo_find(loaded->get_topo_info(p + glm::ivec3(1, 1, 1))) == before, "expanding split the chunk");
+    check(loaded->validate(), "the loaded ship doesn't validate after expanding");
+
+    delete loaded;
+    delete ship;
+
+    printf("%d bad\n", bad);
+    return bad != 0;
+}
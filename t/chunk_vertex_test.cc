@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../src/mesher.h"
+
+/* chunk meshes are kept as chunk_vertex: positions in 16-bit fixed point,
+ * 1/chunk_vertex_scale of a block, the packed normal, and u.
+ *
+ * the layout is what upload_chunk_mesh hands to gl. any position in a
+ * chunk, or a block beyond it, comes back within half a step, and those
+ * on the meshes' own grid come back exactly; the normal and u are kept as
+ * they were. stamping moves a mesh by whole blocks exactly.
+ *
+ * baking a unit cube, made as the loaded meshes are with a vertex for every
+ * corner of every triangle, cuts it up by the faces it lies on -- in
+ * whichever orientation it is turned to -- and welds the corners back
+ * together: each face's part is 4 vertices and 2 triangles, and covers the
+ * whole face. turned off the axes it is all left in one part, still welded.
+ * either way the triangles are those of the float mesh, transformed.
+ */
+
+static int bad = 0;
+
+static void
+check(bool ok, char const *what)
+{
+    if (!ok) {
+        printf("%s\n", what);
+        bad++;
+    }
+}
+
+static float
+frand(float lo, float hi)
+{
+    return lo + (hi - lo) * (rand() / (float)RAND_MAX);
+}
+
+static void
+test_encoding()
+{
+    check(sizeof(chunk_vertex) == 12, "chunk_vertex isn't 12 bytes");
+    check(offsetof(chunk_vertex, x) == 0 && offsetof(chunk_vertex, u) == 6 &&
+          offsetof(chunk_vertex, normal_packed) == 8, "chunk_vertex isn't laid out as gl is told");
+
+    /* a chunk and a block each side must fit */
+    check((CHUNK_SIZE + 1) * chunk_vertex_scale <= 32767, "a chunk doesn't fit in 16 bits");
+
+    srand(1);
+    for (int n = 0; n < 10000 && !bad; n++) {
+        glm::vec3 p(frand(-1, CHUNK_SIZE + 1), frand(-1, CHUNK_SIZE + 1), frand(-1, CHUNK_SIZE + 1));
+        glm::vec3 nrm = glm::normalize(glm::vec3(frand(-1, 1), frand(-1, 1), frand(-1, 1)));
+        float u = frand(0, 1);
+
+        vertex v(p.x, p.y, p.z, nrm.x, nrm.y, nrm.z, u, frand(0, 1));
+        chunk_vertex cv(v);
+
+        if (glm::any(glm::greaterThan(glm::abs(cv.pos() - p), glm::vec3(0.5f / chunk_vertex_scale)))) {
+            printf("%f %f %f came back as %f %f %f\n", p.x, p.y, p.z, cv.pos().x, cv.pos().y, cv.pos().z);
+            bad++;
+        }
+
+        if (cv.normal_packed != v.normal_packed || cv.u != glm::packUnorm1x16(u)) {
+            printf("normal or u changed\n");
+            bad++;
+        }
+
+        /* the meshes are voxels, 16 to the block */
+        glm::vec3 q = glm::floor(p * 16.0f) / 16.0f;
+        chunk_vertex cq(vertex(q.x, q.y, q.z, 0, 0, 1, 0, 0));
+        if (cq.pos() != q) {
+            printf("%f %f %f, on the grid, came back as %f %f %f\n", q.x, q.y, q.z,
+                   cq.pos().x, cq.pos().y, cq.pos().z);
+            bad++;
+        }
+    }
+}
+
+/* a unit cube, every corner of every triangle its own vertex */
+static sw_mesh *
+make_cube()
+{
+    std::vector<vertex> verts;
+
+    for (int axis = 0; axis < 3; axis++) {
+        for (int sign = 1; sign >= -1; sign -= 2) {
+            glm::vec3 o(0), e1(0), e2(0), nrm(0);
+            nrm[axis] = float(sign);
+            if (sign > 0) {
+                o[axis] = 1;
+                e1[(axis + 1) % 3] = 1;
+                e2[(axis + 2) % 3] = 1;
+            }
+            else {
+                e1[(axis + 2) % 3] = 1;
+                e2[(axis + 1) % 3] = 1;
+            }
+
+            glm::vec3 corner[4] = { o, o + e1, o + e1 + e2, o + e2 };
+            int const tris[6] = { 0, 1, 2, 0, 2, 3 };
+            for (int i : tris) {
+                glm::vec3 c = corner[i];
+                verts.push_back(vertex(c.x, c.y, c.z, nrm.x, nrm.y, nrm.z, (axis * 2 + (sign < 0)) / 8.0f, 0));
+            }
+        }
+    }
+
+    auto *m = new sw_mesh;
+    m->num_vertices = m->num_indices = (unsigned)verts.size();
+    m->verts = new vertex[verts.size()];
+    m->indices = new unsigned[verts.size()];
+    for (unsigned i = 0; i < verts.size(); i++) {
+        m->verts[i] = verts[i];
+        m->indices[i] = i;
+    }
+
+    return m;
+}
+
+/* a triangle, as its corners' positions in order from the lowest */
+struct tri {
+    glm::vec3 p[3];
+};
+
+static tri
+canonical(glm::vec3 a, glm::vec3 b, glm::vec3 c)
+{
+    auto less = [](glm::vec3 x, glm::vec3 y) {
+        return x.x != y.x ? x.x < y.x : x.y != y.y ? x.y < y.y : x.z < y.z;
+    };
+
+    /* rotate, keeping the winding, so the least corner is first */
+    if (less(b, a) && !less(c, b)) {
+        return tri{ { b, c, a } };
+    }
+    if (less(c, a) && less(c, b)) {
+        return tri{ { c, a, b } };
+    }
+    return tri{ { a, b, c } };
+}
+
+static bool
+same_tri(tri const &a, tri const &b)
+{
+    for (int n = 0; n < 3; n++) {
+        if (glm::any(glm::greaterThan(glm::abs(a.p[n] - b.p[n]), glm::vec3(1.0f / chunk_vertex_scale)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+cut_matches(sw_mesh const *src, glm::mat4 const &mat, mesher_cut const &cut)
+{
+    std::vector<tri> want, got;
+    for (unsigned t = 0; t < src->num_indices; t += 3) {
+        glm::vec3 p[3];
+        for (int n = 0; n < 3; n++) {
+            vertex const &v = src->verts[src->indices[t + n]];
+            p[n] = glm::vec3(mat * glm::vec4(v.x, v.y, v.z, 1));
+            p[n] = glm::round(p[n] * chunk_vertex_scale) / chunk_vertex_scale;
+        }
+        want.push_back(canonical(p[0], p[1], p[2]));
+    }
+
+    for (int g = 0; g <= int(face_count); g++) {
+        for (unsigned t = 0; t < cut.indices[g].size(); t += 3) {
+            glm::vec3 p[3];
+            for (int n = 0; n < 3; n++) {
+                p[n] = cut.verts[g][cut.indices[g][t + n]].pos();
+            }
+            got.push_back(canonical(p[0], p[1], p[2]));
+        }
+    }
+
+    if (got.size() != want.size()) {
+        return false;
+    }
+
+    for (auto const &w : want) {
+        auto it = std::find_if(got.begin(), got.end(), [&](tri const &g) { return same_tri(g, w); });
+        if (it == got.end()) {
+            return false;
+        }
+        got.erase(it);
+    }
+
+    return true;
+}
+
+static void
+test_cut_and_stamp()
+{
+    sw_mesh *cube = make_cube();
+
+    mesher_cover full;
+    for (int u = 0; u < mesher_face_res; u++) {
+        for (int v = 0; v < mesher_face_res; v++) {
+            full.set(u, v);
+        }
+    }
+
+    /* as it is, and turned a quarter about z (about the block's middle):
+     * every part a face, and covering it */
+    glm::mat4 turns[2] = {
+        glm::mat4(1.0f),
+        glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)) *
+            glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(0, 0, 1)) *
+            glm::translate(glm::mat4(1.0f), glm::vec3(-0.5f)),
+    };
+
+    for (auto const &mat : turns) {
+        mesher_cut cut;
+        mesher_cut_mesh(cube, mat, &cut);
+
+        check(cut_matches(cube, mat, cut), "the cut cube isn't the cube");
+        check(cut.verts[face_count].empty(), "part of the cube lies on no face");
+        for (int f = 0; f < int(face_count); f++) {
+            check(cut.verts[f].size() == 4 && cut.indices[f].size() == 6, "a face of the cube wasn't welded to a quad");
+            check(cut.cover[f].hides(full), "a face of the cube doesn't cover it");
+        }
+    }
+
+    /* off the axes: all in the one part, still welded */
+    glm::mat4 skew = glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)) *
+        glm::rotate(glm::mat4(1.0f), glm::radians(30.0f), glm::vec3(1, 2, 3)) *
+        glm::translate(glm::mat4(1.0f), glm::vec3(-0.5f));
+    mesher_cut cut;
+    mesher_cut_mesh(cube, skew, &cut);
+    check(cut_matches(cube, skew, cut), "the turned cube isn't the cube");
+    check(cut.verts[face_count].size() == 24 && cut.indices[face_count].size() == 36,
+          "the turned cube wasn't welded to 24 vertices");
+
+    /* stamping moves it by whole blocks, exactly */
+    mesher_cut flat;
+    mesher_cut_mesh(cube, glm::mat4(1.0f), &flat);
+    chunk_sw_mesh part = flat.part(surface_xp);
+    for (int n = 0; n < 50; n++) {
+        glm::ivec3 offset(rand() % CHUNK_SIZE, rand() % CHUNK_SIZE, rand() % CHUNK_SIZE);
+        std::vector<chunk_vertex> verts(3);
+        std::vector<unsigned> indices(5);
+        stamp_at_offset(&verts, &indices, &part, offset);
+
+        bool ok = verts.size() == 3 + part.num_vertices && indices.size() == 5 + part.num_indices;
+        for (unsigned i = 0; ok && i < part.num_vertices; i++) {
+            chunk_vertex const &a = verts[3 + i];
+            chunk_vertex const &b = part.verts[i];
+            ok = a.pos() == b.pos() + glm::vec3(offset) && a.u == b.u && a.normal_packed == b.normal_packed;
+        }
+        for (unsigned i = 0; ok && i < part.num_indices; i++) {
+            ok = indices[5 + i] == 3 + part.indices[i];
+        }
+
+        if (!ok) {
+            printf("stamped at %d %d %d wrongly\n", offset.x, offset.y, offset.z);
+            bad++;
+        }
+    }
+
+    delete[] cube->verts;
+    delete[] cube->indices;
+    delete cube;
+}
+
+int
+main(void)
+{
+    test_encoding();
+    test_cut_and_stamp();
+
+    printf("%d bad\n", bad);
+    return bad != 0;
+}
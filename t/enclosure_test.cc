@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <set>
+#include <stdio.h>
+#include <stdlib.h>
+#include <tuple>
+#include <vector>
+
+#include "../src/ship_space.h"
+
+/* ensure_chunk fills in the missing chunks which the ship might enclose --
+ * those with a chunk somewhere beyond them in all six directions -- and no
+ * others. with the chunks around random boxes asked for in a random order,
+ * gaps and all, the chunks which exist after each must be exactly what
+ * repeatedly filling in every such chunk from scratch gives, and the axis
+ * lines it finds them with must hold exactly those chunks.
+ *
+ * and the shapes it is for: a hollow shell is filled in, but the hollow of
+ * an L, which the bounding box covers, is not.
+ */
+
+/* ship_space wants this from the game; nothing is attached here. */
+void
+remove_ents_from_surface(glm::ivec3, int)
+{
+}
+
+static int const extent = 6;   /* chunks are asked for in 0..extent-1 */
+
+struct coord_less {
+    bool operator()(glm::ivec3 a, glm::ivec3 b) const
+    {
+        return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+    }
+};
+
+typedef std::set<glm::ivec3, coord_less> chunk_set;
+
+/* a chunk somewhere beyond v in every direction, looking at them all */
+static bool
+enclosed_in(chunk_set const &s, glm::ivec3 v)
+{
+    for (int face = 0; face < 6; face++) {
+        glm::ivec3 d = surface_index_to_normal((surface_index)face);
+        bool any = false;
+        for (glm::ivec3 p = v + d; !any && glm::all(glm::greaterThanEqual(p, glm::ivec3(-1))) &&
+                glm::all(glm::lessThanEqual(p, glm::ivec3(extent))); p += d) {
+            any = s.count(p) != 0;
+        }
+        if (!any) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* what ensure_chunk should leave, from the chunks asked for */
+static chunk_set
+closure(chunk_set s)
+{
+    bool grew = true;
+    while (grew) {
+        grew = false;
+        for (int z = 0; z < extent; z++) {
+            for (int y = 0; y < extent; y++) {
+                for (int x = 0; x < extent; x++) {
+                    glm::ivec3 v(x, y, z);
+                    if (!s.count(v) && enclosed_in(s, v)) {
+                        s.insert(v);
+                        grew = true;
+                    }
+                }
+            }
+        }
+    }
+
+    return s;
+}
+
+static chunk_set
+chunks_of(ship_space *ship)
+{
+    chunk_set s;
+    for (auto const &e : ship->chunks) {
+        s.insert(e.first);
+    }
+    return s;
+}
+
+static bool
+lines_match(ship_space *ship, chunk_set const &s)
+{
+    size_t count[3] = { 0, 0, 0 };
+    for (int axis = 0; axis < 3; axis++) {
+        for (auto const &line : ship->chunk_lines[axis]) {
+            for (int c : line.second) {
+                glm::ivec3 v = line.first;
+                v[axis] = c;
+                if (line.first[axis] != 0 || !s.count(v)) {
+                    printf("axis %d: line holds %d %d %d, which isn't a chunk\n", axis, v.x, v.y, v.z);
+                    return false;
+                }
+                count[axis]++;
+            }
+        }
+
+        if (count[axis] != s.size()) {
+            printf("axis %d: lines hold %zu chunks, should be %zu\n", axis, count[axis], s.size());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static ship_space *
+ship_of(chunk_set const &asked)
+{
+    auto *ship = new ship_space;
+    for (auto v : asked) {
+        ship->ensure_chunk(v);
+    }
+    return ship;
+}
+
+int
+main(void)
+{
+    int bad = 0;
+    size_t filled = 0;
+    srand(1);
+
+    for (int round = 0; round < 60 && !bad; round++) {
+        /* the chunks around a random box, some missing, and a few strays,
+         * in a random order: so both filling in and not come up */
+        glm::ivec3 lo(rand() % extent, rand() % extent, rand() % extent);
+        glm::ivec3 hi(rand() % extent, rand() % extent, rand() % extent);
+        glm::ivec3 box_lo = glm::min(lo, hi), box_hi = glm::max(lo, hi);
+
+        std::vector<glm::ivec3> order;
+        for (int z = box_lo.z; z <= box_hi.z; z++) {
+            for (int y = box_lo.y; y <= box_hi.y; y++) {
+                for (int x = box_lo.x; x <= box_hi.x; x++) {
+                    glm::ivec3 v(x, y, z);
+                    bool edge = glm::any(glm::equal(v, box_lo)) || glm::any(glm::equal(v, box_hi));
+                    if (edge && rand() % 8) {
+                        order.push_back(v);
+                    }
+                }
+            }
+        }
+
+        for (int n = rand() % 8; n > 0; n--) {
+            order.push_back(glm::ivec3(rand() % extent, rand() % extent, rand() % extent));
+        }
+
+        for (size_t i = order.size(); i > 1; i--) {
+            std::swap(order[i - 1], order[rand() % i]);
+        }
+
+        chunk_set asked;
+        auto *ship = new ship_space;
+
+        for (size_t n = 0; n < order.size(); n++) {
+            asked.insert(order[n]);
+            ship->ensure_chunk(order[n]);
+
+            chunk_set want = closure(asked);
+            chunk_set got = chunks_of(ship);
+            if (got != want) {
+                printf("round %d, chunk %zu: %zu chunks, should be %zu\n", round, n, got.size(), want.size());
+                bad++;
+                break;
+            }
+
+            if (!lines_match(ship, got)) {
+                printf("round %d, chunk %zu\n", round, n);
+                bad++;
+                break;
+            }
+        }
+
+        filled += ship->chunks.size() - asked.size();
+        delete ship;
+    }
+
+    /* a shell of 5x5x5 chunks: the 27 inside are filled in */
+    chunk_set shell;
+    for (int z = 0; z < 5; z++) {
+        for (int y = 0; y < 5; y++) {
+            for (int x = 0; x < 5; x++) {
+                if (x % 4 == 0 || y % 4 == 0 || z % 4 == 0) {
+                    shell.insert(glm::ivec3(x, y, z));
+                }
+            }
+        }
+    }
+
+    ship_space *ship = ship_of(shell);
+    if (ship->chunks.size() != 125) {
+        printf("hollow shell: %zu chunks, should be 125\n", ship->chunks.size());
+        bad++;
+    }
+    delete ship;
+
+    /* an L, one chunk thick: the corner its bounding box covers is left */
+    chunk_set ell;
+    for (int i = 0; i < 5; i++) {
+        ell.insert(glm::ivec3(i, 0, 0));
+        ell.insert(glm::ivec3(0, i, 0));
+    }
+
+    ship = ship_of(ell);
+    if (ship->chunks.size() != ell.size() || ship->get_chunk(glm::ivec3(2, 2, 0))) {
+        printf("L: %zu chunks, should be %zu\n", ship->chunks.size(), ell.size());
+        bad++;
+    }
+    delete ship;
+
+    printf("%zu chunks filled in; %d bad\n", filled, bad);
+    return bad != 0;
+}
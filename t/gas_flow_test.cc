@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "../src/ship_space.h"
+
+/* gas moving between zones through openings.
+ *
+ * gas_flow on its own: a step moves k * dt * (pa - pb) along an edge, so
+ * two zones of known gas come out as worked by hand; and on random graphs
+ * of zones, with edges doubled up and dt far too long for the rates, gas
+ * is kept (bar what reaches vacuum, which holds none), never goes negative,
+ * no zone gives away more than half of what it had, and no edge overshoots
+ * -- its ends' pressures never swap over.
+ *
+ * through the ship: a part open door between a room with air and one
+ * without lets some through, and makes the second room a zone to hold it;
+ * an opening in the hull lets air out to vacuum; an opening whose surface
+ * is gone, or which joins a zone to itself, does nothing; and the outside
+ * is left empty.
+ */
+
+/* ship_space wants this from the game; nothing is attached here. */
+void
+remove_ents_from_surface(glm::ivec3, int)
+{
+}
+
+static int bad = 0;
+
+static void
+check(bool ok, char const *what)
+{
+    if (!ok) {
+        printf("%s\n", what);
+        bad++;
+    }
+}
+
+static bool
+near(float a, float b)
+{
+    return fabsf(a - b) <= 0.0001f * (1 + fabsf(b));
+}
+
+static float
+oxygen(gas_flow const &flow, unsigned i)
+{
+    return flow.amount[int(gas::oxygen)][i];
+}
+
+static void
+test_by_hand()
+{
+    gas_flow flow;
+    float full[int(gas::upper_bound)] = { 100.0f };
+
+    /* 10 blocks each, pressures 10 and 0: 0.1 * (10 - 0) moves */
+    unsigned a = flow.add_zone(nullptr, 10, full);
+    unsigned b = flow.add_zone(nullptr, 10, nullptr);
+    flow.add_edge(a, b, 1.0f);
+    flow.step(0.1f);
+    check(near(oxygen(flow, a), 99.0f) && near(oxygen(flow, b), 1.0f), "two zones: wrong amount moved");
+
+    /* far too long a step: the rate is cut to take half at most, so both
+     * end up at the same pressure, not past it */
+    flow.step(1000.0f);
+    check(oxygen(flow, a) >= oxygen(flow, b) && oxygen(flow, b) > 0, "two zones: a long step overshot");
+    check(near(oxygen(flow, a) + oxygen(flow, b), 100.0f), "two zones: gas made or lost");
+
+    /* vacuum holds nothing, whatever it is given */
+    flow.clear();
+    check(flow.num_zones() == 0 && flow.num_edges() == 0, "clear() left something");
+
+    a = flow.add_zone(nullptr, 10, full);
+    unsigned v = flow.add_zone(nullptr, 0, full);
+    check(oxygen(flow, v) == 0, "vacuum was given gas");
+    flow.add_edge(v, a, 1.0f);
+    flow.step(0.1f);
+    check(near(oxygen(flow, a), 99.0f) && oxygen(flow, v) == 0, "vacuum: wrong amount lost");
+}
+
+static void
+test_random_graphs()
+{
+    srand(1);
+
+    for (int round = 0; round < 200 && !bad; round++) {
+        gas_flow flow;
+        unsigned nz = 2 + rand() % 20;
+        unsigned ne = rand() % (3 * nz);
+        std::vector<bool> vacuum(nz);
+
+        for (unsigned i = 0; i < nz; i++) {
+            float gas[int(gas::upper_bound)] = { float(rand() % 1000) };
+            vacuum[i] = rand() % 8 == 0;
+            flow.add_zone(nullptr, vacuum[i] ? 0 : float(1 + rand() % 64), gas);
+        }
+
+        for (unsigned e = 0; e < ne; e++) {
+            unsigned a = rand() % nz, b = rand() % nz;
+            if (a != b) {
+                flow.add_edge(a, b, (rand() % 100) / 10.0f);
+            }
+        }
+
+        float dt = round % 4 ? 1 / 15.0f : 100.0f;
+        for (int s = 0; s < 20 && !bad; s++) {
+            std::vector<float> before = flow.amount[int(gas::oxygen)];
+            std::vector<float> p(nz);
+            for (unsigned i = 0; i < nz; i++) {
+                p[i] = before[i] * flow.inv_volume[i];
+            }
+
+            flow.step(dt);
+
+            /* what reached vacuum is all that goes */
+            double lost = 0, total_before = 0, total_after = 0;
+            for (unsigned e = 0; e < flow.num_edges(); e++) {
+                unsigned a = flow.edge_a[e], b = flow.edge_b[e];
+                lost += vacuum[b] ? flow.moved[e] : vacuum[a] ? -flow.moved[e] : 0;
+            }
+
+            for (unsigned i = 0; i < nz; i++) {
+                float after = oxygen(flow, i);
+                total_before += before[i];
+                total_after += after;
+
+                if (after < 0 || after < 0.5f * before[i] * (1 - 1e-5f)) {
+                    printf("round %d, step %d: zone %u went from %f to %f\n", round, s, i, before[i], after);
+                    bad++;
+                }
+            }
+
+            if (fabs(total_before - lost - total_after) > 0.001 * (1 + total_before)) {
+                printf("round %d, step %d: %f gas before, %f lost, %f after\n",
+                       round, s, total_before, lost, total_after);
+                bad++;
+            }
+
+            for (unsigned e = 0; e < flow.num_edges(); e++) {
+                unsigned a = flow.edge_a[e], b = flow.edge_b[e];
+                float m = flow.moved[e];
+                if ((m > 0 && p[a] < p[b]) || (m < 0 && p[a] > p[b]) ||
+                        fabsf(m) > 0.5f * std::max(before[a], before[b]) * (1 + 1e-5f)) {
+                    printf("round %d, step %d: edge %u moved %f between pressures %f and %f\n",
+                           round, s, e, m, p[a], p[b]);
+                    bad++;
+                }
+            }
+        }
+    }
+}
+
+/* put a surface on both sides, behind the topology's back as load does */
+static void
+put_surface(ship_space *ship, glm::ivec3 p, int face, surface_type st)
+{
+    glm::ivec3 q = p + surface_index_to_normal((surface_index)face);
+    ship->ensure_block(p).surfs[face] = st;
+    ship->ensure_block(q).surfs[face ^ 1] = st;
+}
+
+static float
+gas_at(ship_space *ship, glm::ivec3 p)
+{
+    zone_info *z = ship->get_zone_info(topo_find(ship->get_topo_info(p)));
+    return z ? z->gas_amount[int(gas::oxygen)] : 0.0f;
+}
+
+static void
+test_ship()
+{
+    /* two rooms of 4x4x4 walled in, side by side along x, with a door
+     * between them at x = 4|5 */
+    auto *ship = new ship_space;
+    for (int z = 1; z <= 4; z++) {
+        for (int y = 1; y <= 4; y++) {
+            for (int x = 1; x <= 8; x++) {
+                glm::ivec3 p(x, y, z);
+                for (int face = 0; face < 6; face++) {
+                    glm::ivec3 q = p + surface_index_to_normal((surface_index)face);
+                    if (q.x < 1 || q.x > 8 || q.y < 1 || q.y > 4 || q.z < 1 || q.z > 4) {
+                        put_surface(ship, p, face, surface_wall);
+                    }
+                }
+            }
+            put_surface(ship, glm::ivec3(4, y, z), surface_xp, surface_door);
+        }
+    }
+    ship->rebuild_topology();
+
+    glm::ivec3 left(2, 2, 2), right(7, 2, 2), door(4, 2, 2);
+    zone_info z{};
+    z.gas_amount[int(gas::oxygen)] = 640.0f;
+    ship->insert_zone(topo_find(ship->get_topo_info(left)), z);
+    check(!ship->get_zone_info(topo_find(ship->get_topo_info(right))), "the empty room has a zone");
+
+    /* shut: nothing moves */
+    ship->tick_gas_flow(0.1f);
+    check(gas_at(ship, left) == 640.0f, "gas moved through a shut door");
+
+    /* part open: some goes through, and the right gets a zone for it */
+    ship->add_opening(door, surface_xp, 0.5f);
+    ship->tick_gas_flow(0.1f);
+    float l = gas_at(ship, left), r = gas_at(ship, right);
+    check(ship->get_zone_info(topo_find(ship->get_topo_info(right))) != nullptr, "no zone made for the gas let through");
+    check(r > 0 && l < 640.0f && near(l + r, 640.0f), "a part open door let the wrong gas through");
+
+    /* held open long enough, the two sides even out */
+    for (int s = 0; s < 200; s++) {
+        ship->tick_gas_flow(1.0f);
+    }
+    check(near(gas_at(ship, left), 320.0f) && near(gas_at(ship, right), 320.0f), "the rooms didn't even out");
+
+    /* an opening within a zone, and one whose surface is gone, do nothing */
+    ship->openings.clear();
+    ship->add_opening(glm::ivec3(2, 2, 2), surface_xp, 1.0f);
+    ship->add_opening(glm::ivec3(3, 3, 3), surface_zp, 1.0f);
+    ship->tick_gas_flow(0.1f);
+    check(ship->flow.num_edges() == 0, "an opening with no door in it let gas through");
+
+    /* a hole in the hull: gas goes out, and is gone */
+    ship->openings.clear();
+    ship->add_opening(glm::ivec3(8, 2, 2), surface_xp, 1.0f);
+    l = gas_at(ship, left);
+    r = gas_at(ship, right);
+    ship->tick_gas_flow(0.1f);
+    check(gas_at(ship, right) < r && gas_at(ship, left) == l, "no gas went out through the hull");
+
+    zone_info *outside = ship->get_zone_info(topo_find(&ship->outside_topo_info));
+    check(!outside || outside->gas_amount[int(gas::oxygen)] == 0, "gas was left outside");
+
+    for (int s = 0; s < 200; s++) {
+        ship->tick_gas_flow(1.0f);
+    }
+    check(gas_at(ship, right) < 0.001f, "the holed room didn't empty");
+
+    delete ship;
+}
+
+int
+main(void)
+{
+    test_by_hand();
+    test_random_graphs();
+    test_ship();
+
+    printf("%d bad\n", bad);
+    return bad != 0;
+}
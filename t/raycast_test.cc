@@ -0,0 +1,241 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/block_cursor.h"
+#include "../src/ship_space.h"
+
+/* ship_space::raycast_block runs straight through chunks the ray can't stop
+ * in -- missing ones, and uniform ones it isn't entering or leaving -- where
+ * the walk it replaced looked at every block. both must give exactly the
+ * same result, to the bit, for every stopping rule: random rays, some along
+ * an axis, some starting inside framing, are cast through a ship of hollow
+ * modules with decks and walls, uniform solid chunks and loose blocks,
+ * either side of the origin, and from well outside it.
+ */
+
+/* ship_space wants this from the game; nothing is attached here. */
+void
+remove_ents_from_surface(glm::ivec3, int)
+{
+}
+
+static float
+max_along_axis(float o, float d)
+{
+    if (d > 0) {
+        return fabsf((ceilf(o) - o)/d);
+    }
+    else {
+        return fabsf((floorf(o) - o)/d);
+    }
+}
+
+/* the previous raycast_block, a step and a block fetch for every cell */
+static bool
+reference_raycast(ship_space *ship, glm::vec3 o, glm::vec3 d, float max_reach_distance,
+                  raycast_stopping_rule stopping_rule, raycast_info_block *rc)
+{
+    rc->hit = false;
+    rc->t = 0.0f;
+
+    int x = (int)(o.x < 0 ? o.x - 1: o.x);
+    int y = (int)(o.y < 0 ? o.y - 1: o.y);
+    int z = (int)(o.z < 0 ? o.z - 1: o.z);
+
+    int nx = 0;
+    int ny = 0;
+    int nz = 0;
+
+    const_block bl;
+
+    block_cursor cur(ship, glm::ivec3(x, y, z));
+    bl = cur.get();
+    rc->inside = bl ? *bl.type != block_empty && *bl.type != block_untouched : false;
+
+    int stepX = d.x > 0 ? 1 : -1;
+    int stepY = d.y > 0 ? 1 : -1;
+    int stepZ = d.z > 0 ? 1 : -1;
+
+    float tDeltaX = fabsf(1/d.x);
+    float tDeltaY = fabsf(1/d.y);
+    float tDeltaZ = fabsf(1/d.z);
+
+    float tMaxX = max_along_axis(o.x, d.x);
+    float tMaxY = max_along_axis(o.y, d.y);
+    float tMaxZ = max_along_axis(o.z, d.z);
+    float t = 0;
+
+    while (t < max_reach_distance) {
+        if (tMaxX < tMaxY) {
+            if (tMaxX < tMaxZ) {
+                x += stepX; cur.step(0, stepX);
+                t = tMaxX; tMaxX += tDeltaX;
+                nx = -stepX; ny = 0; nz = 0;
+            }
+            else {
+                z += stepZ; cur.step(2, stepZ);
+                t = tMaxZ; tMaxZ += tDeltaZ;
+                nx = 0; ny = 0; nz = -stepZ;
+            }
+        }
+        else {
+            if (tMaxY < tMaxZ) {
+                y += stepY; cur.step(1, stepY);
+                t = tMaxY; tMaxY += tDeltaY;
+                nx = 0; ny = -stepY; nz = 0;
+            }
+            else {
+                z += stepZ; cur.step(2, stepZ);
+                t = tMaxZ; tMaxZ += tDeltaZ;
+                nx = 0; ny = 0; nz = -stepZ;
+            }
+        }
+
+        bl = cur.get();
+        if (!bl && !rc->inside) {
+            continue;
+        }
+
+        bool stop = false;
+        if (stopping_rule & enter_exit_framing) {
+            stop = rc->inside ^ (bl && *bl.type != block_empty && *bl.type != block_untouched);
+        }
+        if (!stop && (stopping_rule & cross_surface)) {
+            stop = bl && bl.surfs[normal_to_surface_index(nx, ny, nz)];
+        }
+
+        if (stop) {
+            rc->hit = true;
+            rc->bl = glm::ivec3(x, y, z);
+            rc->block = bl;
+            rc->n = glm::ivec3(nx, ny, nz);
+            rc->p = rc->bl + rc->n;
+            rc->t = t;
+            rc->hitCoord = o + rc->t * d;
+            return true;
+        }
+    }
+    return rc->hit;
+}
+
+/* a hollow box of framing, walled on the outside, with a deck every 4
+ * blocks. the space inside is never touched, so it stays uniform. */
+static void
+build_module(ship_space *ship, glm::ivec3 base, glm::ivec3 size)
+{
+    for (int k = 0; k < size.z; k++) {
+        for (int j = 0; j < size.y; j++) {
+            for (int i = 0; i < size.x; i++) {
+                bool shell = i == 0 || j == 0 || k == 0 ||
+                    i == size.x - 1 || j == size.y - 1 || k == size.z - 1;
+                bool deck = k % 4 == 0;
+                if (!shell && !deck) {
+                    continue;
+                }
+
+                glm::ivec3 p = base + glm::ivec3(i, j, k);
+                *ship->ensure_block(p).type = block_frame;
+
+                if (i == 0) ship->set_surface(p, p + glm::ivec3(-1, 0, 0), surface_xm, surface_wall);
+                if (j == 0) ship->set_surface(p, p + glm::ivec3(0, -1, 0), surface_ym, surface_wall);
+                if (k == 0) ship->set_surface(p, p + glm::ivec3(0, 0, -1), surface_zm, surface_wall);
+            }
+        }
+    }
+}
+
+static float
+frand(float lo, float hi)
+{
+    return lo + (hi - lo) * (rand() / (float)RAND_MAX);
+}
+
+static bool
+same_result(raycast_info_block const &a, raycast_info_block const &b)
+{
+    if (a.hit != b.hit || a.inside != b.inside) {
+        return false;
+    }
+
+    if (!a.hit) {
+        return true;
+    }
+
+    return a.bl == b.bl && a.n == b.n && a.p == b.p &&
+        (bool)a.block == (bool)b.block &&
+        (!a.block || *a.block.type == *b.block.type) &&
+        memcmp(&a.t, &b.t, sizeof(float)) == 0 &&
+        memcmp(&a.hitCoord, &b.hitCoord, sizeof(glm::vec3)) == 0;
+}
+
+int
+main(void)
+{
+    int bad = 0;
+    srand(1);
+
+    auto *ship = new ship_space;
+    ship->rebuild_topology();
+
+    ship->begin_edit();
+    build_module(ship, glm::ivec3(0, 0, 0), glm::ivec3(5 * CHUNK_SIZE, 7 * CHUNK_SIZE, 3 * CHUNK_SIZE + 1));
+    build_module(ship, glm::ivec3(-6 * CHUNK_SIZE, -4 * CHUNK_SIZE, -2 * CHUNK_SIZE),
+                 glm::ivec3(3 * CHUNK_SIZE, 3 * CHUNK_SIZE, 2 * CHUNK_SIZE));
+
+    /* some loose blocks and surfaces in the open */
+    for (int n = 0; n < 60; n++) {
+        glm::ivec3 p(rand() % (12 * CHUNK_SIZE) - 6 * CHUNK_SIZE,
+                     rand() % (12 * CHUNK_SIZE) - 4 * CHUNK_SIZE,
+                     rand() % (6 * CHUNK_SIZE) - 2 * CHUNK_SIZE);
+        *ship->ensure_block(p).type = block_frame;
+        int face = rand() % 6;
+        ship->set_surface(p, p + surface_index_to_normal((surface_index)face), (surface_index)face,
+                          rand() % 2 ? surface_wall : surface_grate);
+    }
+    ship->commit_edit();
+
+    /* and a few solid uniform chunks, which rays stop on entering */
+    for (int n = 0; n < 6; n++) {
+        glm::ivec3 c(7 + n, -3 + n, n % 3);
+        ship->ensure_chunk(c)->uniform_type = block_frame;
+    }
+    ship->rebuild_topology();
+
+    float const lo = -10.0f * CHUNK_SIZE, hi = 12.0f * CHUNK_SIZE;
+    float const reach = 30.0f * CHUNK_SIZE;
+    int hits = 0;
+
+    for (int n = 0; n < 40000 && bad < 10; n++) {
+        glm::vec3 o(frand(lo, hi), frand(lo, hi), frand(lo / 2, hi / 2));
+        glm::vec3 d = glm::normalize(glm::vec3(frand(-1, 1), frand(-1, 1), frand(-1, 1)));
+        if (n % 4 == 0) {
+            /* some along an axis, as tools often are */
+            d = glm::vec3(0);
+            d[n % 3] = n % 8 ? 1.0f : -1.0f;
+        }
+        if (n % 5 == 0) {
+            /* some from inside a deck */
+            o.z = floorf(o.z / 4) * 4 + frand(0.01f, 0.99f);
+        }
+
+        auto rule = (raycast_stopping_rule)(n % 3 + 1);
+        raycast_info_block a, b;
+        reference_raycast(ship, o, d, reach, rule, &a);
+        ship->raycast_block(o, d, reach, rule, &b);
+
+        hits += a.hit;
+        if (!same_result(a, b)) {
+            printf("ray %d from %f %f %f along %f %f %f, rule %d: hit %d at %d %d %d, should be %d at %d %d %d\n",
+                   n, o.x, o.y, o.z, d.x, d.y, d.z, rule, b.hit, b.bl.x, b.bl.y, b.bl.z,
+                   a.hit, a.bl.x, a.bl.y, a.bl.z);
+            bad++;
+        }
+    }
+
+    delete ship;
+
+    printf("%d hits; %d bad\n", hits, bad);
+    return bad != 0;
+}
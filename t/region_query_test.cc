@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <tuple>
+#include <vector>
+
+#include "../src/ship_space.h"
+
+/* the region queries must visit just what looking at every block in the
+ * region one at a time would: each block in an existing chunk once, each
+ * surface and each wire once from every side in range, and nothing outside
+ * the region or in a missing chunk. boxes are picked at random, from single
+ * blocks to far bigger than the ship (where the chunk list is walked
+ * instead), and spheres likewise, over a ship with missing chunks, uniform
+ * chunks and expanded ones, either side of the origin.
+ */
+
+/* ship_space wants this from the game; nothing is attached here. */
+void
+remove_ents_from_surface(glm::ivec3, int)
+{
+}
+
+static int const extent = 3;   /* in chunks, each way from the origin */
+
+/* one thing visited: a block (face -1), or a surface or wire on one face */
+struct visit {
+    int x, y, z, face, what;
+
+    bool operator<(visit const &o) const
+    {
+        return std::tie(x, y, z, face, what) < std::tie(o.x, o.y, o.z, o.face, o.what);
+    }
+
+    bool operator==(visit const &o) const
+    {
+        return std::tie(x, y, z, face, what) == std::tie(o.x, o.y, o.z, o.face, o.what);
+    }
+};
+
+typedef std::vector<visit> visits;
+
+static visit
+visit_of(glm::ivec3 p, int face, int what)
+{
+    return visit{ p.x, p.y, p.z, face, what };
+}
+
+/* everything in the box, one block at a time; in_region picks blocks */
+template<typename F>
+static void
+expect(ship_space *ship, glm::ivec3 mins, glm::ivec3 maxs, F const &in_region,
+       visits &blocks, visits &surfaces, visits &wires)
+{
+    /* no chunk lies outside these, however big the box */
+    glm::ivec3 lo = glm::max(mins, glm::ivec3(-extent * CHUNK_SIZE));
+    glm::ivec3 hi = glm::min(maxs, glm::ivec3(extent * CHUNK_SIZE - 1));
+
+    for (int x = lo.x; x <= hi.x; x++) {
+        for (int y = lo.y; y <= hi.y; y++) {
+            for (int z = lo.z; z <= hi.z; z++) {
+                glm::ivec3 p(x, y, z);
+                const_block bl = ship->peek_block(p);
+                if (!bl || !in_region(p)) {
+                    continue;
+                }
+
+                blocks.push_back(visit_of(p, -1, *bl.type));
+                for (int face = 0; face < 6; face++) {
+                    if (bl.surfs[face]) {
+                        surfaces.push_back(visit_of(p, face, bl.surfs[face]));
+                    }
+                    if (bl.has_wire(face)) {
+                        wires.push_back(visit_of(p, face, bl.wire_bits[face]));
+                    }
+                }
+            }
+        }
+    }
+}
+
+static bool
+same(visits a, visits b, char const *what)
+{
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    if (a != b) {
+        printf("%s: %zu visited, should be %zu\n", what, a.size(), b.size());
+        return false;
+    }
+
+    return true;
+}
+
+static glm::ivec3
+random_block(int n)
+{
+    return glm::ivec3(rand() % (2 * n) - n, rand() % (2 * n) - n, rand() % (2 * n) - n);
+}
+
+int
+main(void)
+{
+    int bad = 0;
+    srand(1);
+
+    /* most chunks, some of them uniform frame, and a scattering of blocks
+     * with surfaces and wires in the rest */
+    auto *ship = new ship_space;
+    for (int k = -extent; k < extent; k++) {
+        for (int j = -extent; j < extent; j++) {
+            for (int i = -extent; i < extent; i++) {
+                if (rand() % 4) {
+                    chunk *ch = ship->ensure_chunk(glm::ivec3(i, j, k));
+                    ch->uniform_type = rand() % 3 ? block_untouched : block_frame;
+                }
+            }
+        }
+    }
+
+    for (int n = 0; n < 400; n++) {
+        glm::ivec3 p = random_block(extent * CHUNK_SIZE);
+        chunk *ch = ship->get_chunk_containing(p);
+        if (!ch || (ch->is_uniform() && rand() % 4)) {
+            continue;
+        }
+
+        block bl = ship->get_block(p);
+        *bl.type = rand() % 2 ? block_frame : block_empty;
+        int face = rand() % 6;
+        if (rand() % 2) {
+            bl.surfs[face] = surface_wall;
+            block other = ship->get_block(p + surface_index_to_normal((surface_index)face));
+            if (other) {
+                other.surfs[face ^ 1] = surface_wall;
+            }
+        }
+        else {
+            bl.set_has_wire(face, true);
+            bl.wire_bits[face] = (unsigned char)(1 + rand() % 200);
+        }
+    }
+
+    for (int round = 0; round < 300 && !bad; round++) {
+        visits got_blocks, got_surfaces, got_wires;
+        visits want_blocks, want_surfaces, want_wires;
+
+        if (round % 2) {
+            /* a box: mostly inside the ship, sometimes far bigger */
+            int r = round % 10 == 1 ? 1000 : 1 + rand() % (2 * CHUNK_SIZE);
+            glm::ivec3 a = random_block(extent * CHUNK_SIZE + 2);
+            glm::ivec3 mins = a - glm::ivec3(rand() % r, rand() % r, rand() % r);
+            glm::ivec3 maxs = a + glm::ivec3(rand() % r, rand() % r, rand() % r);
+
+            ship->for_each_block(mins, maxs, [&](glm::ivec3 p, const_block bl) {
+                got_blocks.push_back(visit_of(p, -1, *bl.type));
+            });
+            ship->for_each_surface(mins, maxs, [&](glm::ivec3 p, int face, surface_type st) {
+                got_surfaces.push_back(visit_of(p, face, st));
+            });
+            ship->for_each_wire(mins, maxs, [&](glm::ivec3 p, int face, block bl) {
+                got_wires.push_back(visit_of(p, face, bl.wire_bits[face]));
+            });
+
+            expect(ship, mins, maxs, [](glm::ivec3) { return true; },
+                   want_blocks, want_surfaces, want_wires);
+        }
+        else {
+            /* a sphere, anywhere between blocks */
+            glm::vec3 c = glm::vec3(random_block(extent * CHUNK_SIZE + 2)) +
+                          glm::vec3(rand() % 100, rand() % 100, rand() % 100) / 100.0f;
+            float r = round % 10 == 0 ? 1000.0f : (rand() % (300 * CHUNK_SIZE)) / 100.0f;
+
+            ship->for_each_block_in_sphere(c, r, [&](glm::ivec3 p, const_block bl) {
+                got_blocks.push_back(visit_of(p, -1, *bl.type));
+            });
+            ship->for_each_surface_in_sphere(c, r, [&](glm::ivec3 p, int face, surface_type st) {
+                got_surfaces.push_back(visit_of(p, face, st));
+            });
+            ship->for_each_wire_in_sphere(c, r, [&](glm::ivec3 p, int face, block bl) {
+                got_wires.push_back(visit_of(p, face, bl.wire_bits[face]));
+            });
+
+            glm::ivec3 ir = glm::ivec3((int)r + 2);
+            expect(ship, glm::ivec3(c) - ir, glm::ivec3(c) + ir,
+                   [&](glm::ivec3 p) { return block_in_sphere(p, c, r); },
+                   want_blocks, want_surfaces, want_wires);
+        }
+
+        if (!same(got_blocks, want_blocks, "blocks") ||
+                !same(got_surfaces, want_surfaces, "surfaces") ||
+                !same(got_wires, want_wires, "wires")) {
+            printf("round %d\n", round);
+            bad++;
+        }
+    }
+
+    delete ship;
+
+    printf("%d bad\n", bad);
+    return bad != 0;
+}
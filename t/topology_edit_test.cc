@@ -0,0 +1,371 @@
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/ship_space.h"
+
+/* the topology set_surface keeps up as it goes -- splitting zones when a
+ * surface closes a room off, joining them when one opens -- must come out
+ * the same as rebuilding it from scratch. random surface edits are made
+ * through the public api, one at a time and in batches, on ships of
+ * walled-off rooms with a few holes in the walls. after each, a copy of
+ * the ship is made with the same blocks and the same zones (as save and
+ * load would), and rebuilt; the two must have the same components, of the
+ * same sizes, holding the same gas.
+ *
+ * a rebuild can't say how a split zone's gas should have been shared out,
+ * so after a single edit that is checked against the ship as it was: each
+ * piece keeps the pressure it had, and a join adds the gas up.
+ */
+
+/* ship_space wants this from the game; nothing is attached here. */
+void
+remove_ents_from_surface(glm::ivec3, int)
+{
+}
+
+static int const ship_chunks = 6;
+static int const ship_blocks = ship_chunks * CHUNK_SIZE;
+
+struct wall {
+    glm::ivec3 p;
+    int face;
+};
+
+/* put a surface on both sides, behind the topology's back as load does */
+static void
+put_surface(ship_space *ship, glm::ivec3 p, int face, surface_type st)
+{
+    glm::ivec3 q = p + surface_index_to_normal((surface_index)face);
+    ship->ensure_block(p).surfs[face] = st;
+    ship->ensure_block(q).surfs[face ^ 1] = st;
+}
+
+/* a hull just inside the edge, and rooms walled off inside it. the inner
+ * walls have holes in them, which are what the edits mostly go after:
+ * closing the last hole in a wall splits a room in two. */
+static ship_space *
+build_ship(unsigned seed, std::vector<wall> &walls, std::vector<wall> &holes)
+{
+    srand(seed);
+    auto *ship = new ship_space;
+    walls.clear();
+    holes.clear();
+
+    for (int k = 0; k < ship_chunks; k++) {
+        for (int j = 0; j < ship_chunks; j++) {
+            for (int i = 0; i < ship_chunks; i++) {
+                ship->ensure_chunk(glm::ivec3(i, j, k));
+            }
+        }
+    }
+
+    for (int n = 0; n < 10; n++) {
+        int axis = n < 6 ? n >> 1 : rand() % 3;
+        int c = n < 6 ? (n & 1) * (ship_blocks - 2) : 1 + rand() % (ship_blocks - 3);
+        int num_holes = n < 6 ? 0 : 1 + rand() % 3;
+        for (int v = 1; v < ship_blocks - 1; v++) {
+            for (int u = 1; u < ship_blocks - 1; u++) {
+                glm::ivec3 p;
+                p[axis] = c;
+                p[(axis + 1) % 3] = u;
+                p[(axis + 2) % 3] = v;
+
+                put_surface(ship, p, 2 * axis, surface_wall);
+                walls.push_back(wall{p, 2 * axis});
+            }
+        }
+
+        for (int h = 0; h < num_holes; h++) {
+            glm::ivec3 p;
+            p[axis] = c;
+            p[(axis + 1) % 3] = 1 + rand() % (ship_blocks - 2);
+            p[(axis + 2) % 3] = 1 + rand() % (ship_blocks - 2);
+
+            put_surface(ship, p, 2 * axis, surface_none);
+            holes.push_back(wall{p, 2 * axis});
+        }
+    }
+
+    ship->rebuild_topology(1);
+
+    /* and some air in the rooms */
+    for (int n = 0; n < 12; n++) {
+        glm::ivec3 p(1 + rand() % (ship_blocks - 2), 1 + rand() % (ship_blocks - 2),
+                     1 + rand() % (ship_blocks - 2));
+        zone_info z{};
+        z.gas_amount[int(gas::oxygen)] = float(rand() % 1000);
+        ship->insert_zone(topo_find(ship->get_topo_info(p)), z);
+    }
+
+    return ship;
+}
+
+/* flip one surface, through the api: shut if it lets air through, open
+ * (or another kind of surface which lets air through) if not */
+static void
+flip_surface(ship_space *ship, wall const &w)
+{
+    static surface_type const shut[] = { surface_wall, surface_door, surface_glass };
+    static surface_type const open[] = { surface_none, surface_grate };
+
+    glm::ivec3 q = w.p + surface_index_to_normal((surface_index)w.face);
+    surface_type st = ship->peek_block(w.p).surfs[w.face];
+    surface_type to = air_permeable(st) ? shut[rand() % 3] : open[rand() % 2];
+    ship->set_surface(w.p, q, (surface_index)w.face, to);
+}
+
+/* mostly the holes, sometimes any part of a wall */
+static wall const &
+pick_surface(std::vector<wall> const &walls, std::vector<wall> const &holes)
+{
+    if (!holes.empty() && rand() % 3) {
+        return holes[rand() % holes.size()];
+    }
+
+    return walls[rand() % walls.size()];
+}
+
+/* the same blocks, with topology rebuilt, and the zones put back where
+ * they were -- as saving and loading ship would */
+static ship_space *
+rebuilt_copy(ship_space *ship)
+{
+    auto *copy = new ship_space;
+
+    for (auto c : ship->chunks) {
+        chunk *from = c.second;
+        chunk *to = copy->ensure_chunk(c.first);
+        if (from->is_uniform()) {
+            to->uniform_type = from->uniform_type;
+            continue;
+        }
+
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            for (int y = 0; y < CHUNK_SIZE; y++) {
+                for (int x = 0; x < CHUNK_SIZE; x++) {
+                    const_block a = from->peek_block(x, y, z);
+                    block b = copy->ensure_block(CHUNK_SIZE * c.first + glm::ivec3(x, y, z));
+                    *b.type = *a.type;
+                    for (int f = 0; f < 6; f++) {
+                        b.surfs[f] = a.surfs[f];
+                    }
+                }
+            }
+        }
+    }
+
+    copy->rebuild_topology(1);
+
+    ship->for_each_zone([&](topo_info *t, zone_info &z) {
+        glm::ivec3 p;
+        if (ship->topo_to_pos(t, &p)) {
+            copy->insert_zone(topo_find(copy->get_topo_info(p)), z);
+        }
+    });
+
+    return copy;
+}
+
+/* the pressure every block was at, by its component */
+struct pressures {
+    std::vector<float> at;
+};
+
+static int
+block_index(glm::ivec3 p)
+{
+    int const n = ship_blocks + 2;
+    return (p.x + 1) + n * ((p.y + 1) + n * (p.z + 1));
+}
+
+static pressures
+take_pressures(ship_space *ship)
+{
+    int const n = ship_blocks + 2;
+    topo_info *outside = topo_find(&ship->outside_topo_info);
+    pressures ps;
+    ps.at.resize(n * n * n);
+
+    for (int z = -1; z <= ship_blocks; z++) {
+        for (int y = -1; y <= ship_blocks; y++) {
+            for (int x = -1; x <= ship_blocks; x++) {
+                glm::ivec3 p(x, y, z);
+                topo_info *t = topo_find(ship->get_topo_info(p));
+                zone_info *zi = ship->get_zone_info(t);
+                ps.at[block_index(p)] = t == outside || !zi ? 0 : zi->gas_amount[int(gas::oxygen)] / t->size;
+            }
+        }
+    }
+
+    return ps;
+}
+
+/* does every component hold the gas its blocks held before? */
+static bool
+kept_pressure(ship_space *ship, pressures const &before)
+{
+    std::unordered_map<topo_info *, float> expect;
+    topo_info *outside = topo_find(&ship->outside_topo_info);
+
+    for (int z = -1; z <= ship_blocks; z++) {
+        for (int y = -1; y <= ship_blocks; y++) {
+            for (int x = -1; x <= ship_blocks; x++) {
+                glm::ivec3 p(x, y, z);
+                topo_info *t = topo_find(ship->get_topo_info(p));
+                if (t != outside) {
+                    expect[t] += before.at[block_index(p)];
+                }
+            }
+        }
+    }
+
+    for (auto &e : expect) {
+        zone_info *zi = ship->get_zone_info(e.first);
+        float g = zi ? zi->gas_amount[int(gas::oxygen)] : 0;
+        if (fabsf(g - e.second) > 0.001f * (1 + fabsf(e.second))) {
+            printf("component of %d blocks: gas %f, should be %f\n", e.first->size, g, e.second);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* is every block of a in the same component as its twin in b, with the
+ * same gas? the outside's zone is let go of as it fills, so isn't
+ * compared. */
+static bool
+same_topology(ship_space *a, ship_space *b)
+{
+    std::unordered_map<topo_info *, topo_info *> ab, ba;
+    topo_info *a_out = topo_find(&a->outside_topo_info);
+    topo_info *b_out = topo_find(&b->outside_topo_info);
+
+    for (int z = -1; z <= ship_blocks; z++) {
+        for (int y = -1; y <= ship_blocks; y++) {
+            for (int x = -1; x <= ship_blocks; x++) {
+                glm::ivec3 p(x, y, z);
+                topo_info *ta = topo_find(a->get_topo_info(p));
+                topo_info *tb = topo_find(b->get_topo_info(p));
+
+                auto ia = ab.insert(std::make_pair(ta, tb)).first;
+                auto ib = ba.insert(std::make_pair(tb, ta)).first;
+                if (ia->second != tb || ib->second != ta) {
+                    printf("%d %d %d: in different components\n", x, y, z);
+                    return false;
+                }
+
+                if ((ta == a_out) != (tb == b_out)) {
+                    printf("%d %d %d: open to vacuum in only one\n", x, y, z);
+                    return false;
+                }
+
+                if (ta == a_out) {
+                    continue;
+                }
+
+                if (ta->size != tb->size) {
+                    printf("%d %d %d: component sizes %d and %d\n", x, y, z, ta->size, tb->size);
+                    return false;
+                }
+
+                zone_info *za = a->get_zone_info(ta);
+                zone_info *zb = b->get_zone_info(tb);
+                float ga = za ? za->gas_amount[int(gas::oxygen)] : 0;
+                float gb = zb ? zb->gas_amount[int(gas::oxygen)] : 0;
+                if (fabsf(ga - gb) > 0.001f * (1 + fabsf(ga))) {
+                    printf("%d %d %d: zone gas %f and %f\n", x, y, z, ga, gb);
+                    return false;
+                }
+            }
+        }
+    }
+
+    /* two zones on one component would have been added together in b */
+    if (a->zone_count() != b->zone_count()) {
+        printf("%zu zones, %zu after a rebuild\n", a->zone_count(), b->zone_count());
+        return false;
+    }
+
+    return true;
+}
+
+int
+main(void)
+{
+    int bad = 0;
+    int splits = 0, unifys = 0;
+
+    for (unsigned seed = 1; seed <= 4; seed++) {
+        std::vector<wall> walls, holes;
+        ship_space *ship = build_ship(seed, walls, holes);
+
+        for (int edit = 0; edit < 150 && !bad; edit++) {
+            int before = ship->num_fast_splits;
+            int kind = rand() % 4;
+
+            if (kind == 0) {
+                /* a batch, which may flip the same surface more than once,
+                 * and may be nested */
+                int count = 1 + rand() % 20;
+                ship->begin_edit();
+                for (int n = 0; n < count; n++) {
+                    if (rand() % 8 == 0) {
+                        ship->begin_edit();
+                        flip_surface(ship, pick_surface(walls, holes));
+                        ship->commit_edit();
+                    }
+                    flip_surface(ship, pick_surface(walls, holes));
+                }
+                ship->commit_edit();
+            }
+            else if (kind == 1) {
+                /* every hole at once, in one batch */
+                ship->begin_edit();
+                for (auto &h : holes) {
+                    flip_surface(ship, h);
+                }
+                ship->commit_edit();
+            }
+            else {
+                pressures ps = take_pressures(ship);
+                flip_surface(ship, pick_surface(walls, holes));
+
+                if (!kept_pressure(ship, ps)) {
+                    printf("seed %u: edit %d moved gas between blocks\n", seed, edit);
+                    bad++;
+                }
+            }
+
+            splits += ship->num_fast_splits != before;
+
+            ship_space *copy = rebuilt_copy(ship);
+            if (!same_topology(ship, copy)) {
+                printf("seed %u: edit %d (kind %d) differs from a rebuild\n", seed, edit, kind);
+                bad++;
+            }
+            delete copy;
+        }
+
+        /* roots merged away are given back, not kept for as long as the
+         * ship is edited */
+        int dead = 0;
+        for (auto r : ship->topo_roots) {
+            dead += r->node.p != &r->node;
+        }
+        if (dead > std::max<int>(64, (int)ship->chunks.size())) {
+            printf("seed %u: %d roots merged away are still held\n", seed, dead);
+            bad++;
+        }
+
+        unifys += ship->num_fast_unifys;
+        delete ship;
+    }
+
+    printf("%d edits split a zone, %d unifys; %d bad\n", splits, unifys, bad);
+    return bad != 0;
+}
@@ -0,0 +1,279 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/ship_space.h"
+
+/* rebuild_topology spread over several threads must come out the same as
+ * on one: the same components, of the same sizes, open to vacuum or not,
+ * holding the same zones. checked on random ships of partly walled-off
+ * chunks with gaps in them, after some walls have gone without the
+ * topology being told, so that the rebuild has zones to merge. the one
+ * thread result is itself checked against a plain flood fill.
+ */
+
+/* ship_space wants this from the game; nothing is attached here. */
+void
+remove_ents_from_surface(glm::ivec3, int)
+{
+}
+
+static int const ship_chunks = 8;
+static int const ship_blocks = ship_chunks * CHUNK_SIZE;
+
+struct wall {
+    glm::ivec3 p;
+    int face;
+};
+
+/* put (or take away) a surface on both sides, behind the topology's back
+ * as load does */
+static void
+put_surface(ship_space *ship, glm::ivec3 p, int face, surface_type st)
+{
+    glm::ivec3 q = p + surface_index_to_normal((surface_index)face);
+    ship->ensure_block(p).surfs[face] = st;
+    ship->ensure_block(q).surfs[face ^ 1] = st;
+}
+
+static ship_space *
+build_ship(unsigned seed, std::vector<wall> &walls)
+{
+    srand(seed);
+    auto *ship = new ship_space;
+    walls.clear();
+
+    for (int k = 0; k < ship_chunks; k++) {
+        for (int j = 0; j < ship_chunks; j++) {
+            for (int i = 0; i < ship_chunks; i++) {
+                if (rand() % 40) {
+                    ship->ensure_chunk(glm::ivec3(i, j, k));
+                }
+            }
+        }
+    }
+
+    /* a hull just inside the edge, and walls right across the ship making
+     * rooms. walls are sometimes holed, and a missing chunk holes
+     * everything around it. */
+    for (int n = 0; n < 12; n++) {
+        int axis = n < 6 ? n >> 1 : rand() % 3;
+        int c = n < 6 ? (n & 1) * (ship_blocks - 2) : rand() % (ship_blocks - 1);
+        int holes = n < 6 ? 0 : rand() % 3;
+        for (int v = 0; v < ship_blocks; v++) {
+            for (int u = 0; u < ship_blocks; u++) {
+                glm::ivec3 p;
+                p[axis] = c;
+                p[(axis + 1) % 3] = u;
+                p[(axis + 2) % 3] = v;
+
+                glm::ivec3 q = p;
+                q[axis]++;
+                if ((holes && rand() % 500 < holes) ||
+                    !ship->get_chunk_containing(p) || !ship->get_chunk_containing(q)) {
+                    continue;
+                }
+
+                put_surface(ship, p, 2 * axis, surface_wall);
+                walls.push_back(wall{p, 2 * axis});
+            }
+        }
+    }
+
+    /* and some scattered small ones */
+    for (int n = 0; n < 2000; n++) {
+        glm::ivec3 p(rand() % ship_blocks, rand() % ship_blocks, rand() % ship_blocks);
+        int face = rand() % 6;
+        glm::ivec3 q = p + surface_index_to_normal((surface_index)face);
+        if (!ship->get_chunk_containing(p) || !ship->get_chunk_containing(q)) {
+            continue;
+        }
+
+        put_surface(ship, p, face, rand() % 4 ? surface_wall : surface_grate);
+        walls.push_back(wall{p, face});
+    }
+
+    return ship;
+}
+
+/* give the ship some air, then knock out some walls unannounced */
+static void
+disturb_ship(ship_space *ship, unsigned seed, std::vector<wall> const &walls)
+{
+    srand(seed + 1);
+
+    for (int n = 0; n < 40; n++) {
+        glm::ivec3 p(rand() % ship_blocks, rand() % ship_blocks, rand() % ship_blocks);
+        zone_info z{};
+        z.gas_amount[int(gas::oxygen)] = float(rand() % 1000);
+        ship->insert_zone(topo_find(ship->get_topo_info(p)), z);
+    }
+
+    for (auto &w : walls) {
+        if (rand() % 500 == 0) {
+            put_surface(ship, w.p, w.face, surface_none);
+        }
+    }
+}
+
+/* does a flood fill from each block agree with the topology of ship? */
+static bool
+matches_flood(ship_space *ship)
+{
+    int const n = ship_blocks;
+    std::vector<int> label(n * n * n, -1);
+    topo_info *outside = topo_find(&ship->outside_topo_info);
+
+    for (int start = 0; start < n * n * n; start++) {
+        glm::ivec3 s(start % n, start / n % n, start / n / n);
+        if (label[start] != -1 || !ship->peek_block(s)) {
+            continue;
+        }
+
+        std::vector<glm::ivec3> stack(1, s), members;
+        bool vented = false;
+        label[start] = start;
+
+        while (!stack.empty()) {
+            glm::ivec3 p = stack.back();
+            stack.pop_back();
+            members.push_back(p);
+
+            const_block bl = ship->peek_block(p);
+            for (int face = 0; face < 6; face++) {
+                if (!air_permeable(bl.surfs[face])) {
+                    continue;
+                }
+
+                glm::ivec3 q = p + surface_index_to_normal((surface_index)face);
+                if (glm::any(glm::lessThan(q, glm::ivec3(0))) ||
+                    glm::any(glm::greaterThanEqual(q, glm::ivec3(n))) || !ship->peek_block(q)) {
+                    vented = true;
+                    continue;
+                }
+
+                int &l = label[q.x + n * (q.y + n * q.z)];
+                if (l == -1) {
+                    l = start;
+                    stack.push_back(q);
+                }
+            }
+        }
+
+        topo_info *t = topo_find(ship->get_topo_info(s));
+        if ((t == outside) != vented) {
+            printf("%d %d %d: open to vacuum is %d, flood fill says %d\n", s.x, s.y, s.z, t == outside, vented);
+            return false;
+        }
+
+        if (!vented && t->size != (int)members.size()) {
+            printf("%d %d %d: component size %d, flood fill found %zu\n", s.x, s.y, s.z, t->size, members.size());
+            return false;
+        }
+
+        for (auto p : members) {
+            if (topo_find(ship->get_topo_info(p)) != t) {
+                printf("%d %d %d: not with %d %d %d, though the flood fill reached it\n",
+                       p.x, p.y, p.z, s.x, s.y, s.z);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/* is every block of a in the same component as its twin in b? */
+static bool
+same_topology(ship_space *a, ship_space *b)
+{
+    std::unordered_map<topo_info *, topo_info *> ab, ba;
+    topo_info *a_out = topo_find(&a->outside_topo_info);
+    topo_info *b_out = topo_find(&b->outside_topo_info);
+
+    for (int z = -1; z <= ship_blocks; z++) {
+        for (int y = -1; y <= ship_blocks; y++) {
+            for (int x = -1; x <= ship_blocks; x++) {
+                glm::ivec3 p(x, y, z);
+                topo_info *ta = topo_find(a->get_topo_info(p));
+                topo_info *tb = topo_find(b->get_topo_info(p));
+
+                auto ia = ab.insert(std::make_pair(ta, tb)).first;
+                auto ib = ba.insert(std::make_pair(tb, ta)).first;
+                if (ia->second != tb || ib->second != ta) {
+                    printf("%d %d %d: in different components\n", x, y, z);
+                    return false;
+                }
+
+                if ((ta == a_out) != (tb == b_out)) {
+                    printf("%d %d %d: open to vacuum in only one\n", x, y, z);
+                    return false;
+                }
+
+                if (ta->size != tb->size) {
+                    printf("%d %d %d: component sizes %d and %d\n", x, y, z, ta->size, tb->size);
+                    return false;
+                }
+
+                zone_info *za = a->get_zone_info(ta);
+                zone_info *zb = b->get_zone_info(tb);
+                if (!za != !zb) {
+                    printf("%d %d %d: zone in only one\n", x, y, z);
+                    return false;
+                }
+
+                /* the zones merged may be summed in another order */
+                float ga = za ? za->gas_amount[int(gas::oxygen)] : 0;
+                float gb = zb ? zb->gas_amount[int(gas::oxygen)] : 0;
+                if (fabsf(ga - gb) > 0.001f * (1 + fabsf(ga))) {
+                    printf("%d %d %d: zone gas %f and %f\n", x, y, z, ga, gb);
+                    return false;
+                }
+            }
+        }
+    }
+
+    return a->zone_count() == b->zone_count();
+}
+
+int
+main(void)
+{
+    int bad = 0;
+
+    for (unsigned seed = 1; seed <= 20; seed++) {
+        std::vector<wall> walls;
+        ship_space *serial = build_ship(seed, walls);
+        ship_space *parallel[] = { build_ship(seed, walls), build_ship(seed, walls) };
+        unsigned threads[] = { 3, 8 };
+
+        serial->rebuild_topology(1);
+        disturb_ship(serial, seed, walls);
+        serial->rebuild_topology(1);
+
+        if (!matches_flood(serial)) {
+            printf("seed %u: one thread differs from a flood fill\n", seed);
+            bad++;
+        }
+
+        for (int n = 0; n < 2; n++) {
+            parallel[n]->rebuild_topology(threads[n]);
+            disturb_ship(parallel[n], seed, walls);
+            parallel[n]->rebuild_topology(threads[n]);
+
+            if (!same_topology(serial, parallel[n])) {
+                printf("seed %u: %u threads differ from one\n", seed, threads[n]);
+                bad++;
+            }
+
+            delete parallel[n];
+        }
+
+        delete serial;
+    }
+
+    printf("%d bad\n", bad);
+    return bad != 0;
+}